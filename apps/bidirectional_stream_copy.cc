@@ -16,8 +16,8 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
   EventLoop _eventloop {};
   FileDescriptor _input { STDIN_FILENO };
   FileDescriptor _output { STDOUT_FILENO };
-  ByteStream _outbound { buffer_size };
-  ByteStream _inbound { buffer_size };
+  ByteStream _outbound { buffer_size, ByteStream::Storage::Chunked };
+  ByteStream _inbound { buffer_size, ByteStream::Storage::Chunked };
   bool _outbound_shutdown { false };
   bool _inbound_shutdown { false };
 
@@ -56,10 +56,11 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     socket,
     Direction::Out,
     [&] {
-      if ( _outbound.reader().bytes_buffered() ) {
-        _outbound.reader().pop( socket.write( _outbound.reader().peek() ) );
+      Reader& outbound = _outbound.reader();
+      if ( outbound.bytes_buffered() ) {
+        outbound.pop( socket.write( outbound.peek_iov( outbound.bytes_buffered() ) ) );
       }
-      if ( _outbound.reader().is_finished() ) {
+      if ( outbound.is_finished() ) {
         socket.shutdown( SHUT_WR );
         _outbound_shutdown = true;
         cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
@@ -106,10 +107,11 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     _output,
     Direction::Out,
     [&] {
-      if ( _inbound.reader().bytes_buffered() ) {
-        _inbound.reader().pop( _output.write( _inbound.reader().peek() ) );
+      Reader& inbound = _inbound.reader();
+      if ( inbound.bytes_buffered() ) {
+        inbound.pop( _output.write( inbound.peek_iov( inbound.bytes_buffered() ) ) );
       }
-      if ( _inbound.reader().is_finished() ) {
+      if ( inbound.is_finished() ) {
         _output.close();
         _inbound_shutdown = true;
         cerr << "DEBUG: Inbound stream from " << peer_name << " finished"
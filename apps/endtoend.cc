@@ -132,7 +132,12 @@ public:
     _interface.datagrams_received().pop();
     return unwrap_tcp_in_ip( dgram );
   }
-  void write( const TCPMessage& msg ) { _interface.send_datagram( wrap_tcp_in_ip( msg ), _next_hop ); }
+  void write( const TCPMessage& msg )
+  {
+    for ( const auto& dgram : wrap_tcp_in_ip_segments( msg ) ) {
+      _interface.send_datagram( dgram, _next_hop );
+    }
+  }
   void tick( const size_t ms_since_last_tick ) { _interface.tick( ms_since_last_tick ); }
   NetworkInterface& interface() { return _interface; }
 
@@ -23,6 +23,8 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_spsc)
+ttest(tcp_minnow_in_process)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,6 +33,7 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_retain)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -45,6 +48,9 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_sack)
+ttest(recv_window_scale)
+ttest(recv_timestamps)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +59,16 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_congestion)
+ttest(send_rtt)
+ttest(send_mss)
+ttest(send_nagle)
+ttest(send_persist)
+
+ttest(tcp_segment_options)
+ttest(timer_wheel)
+ttest(tcp_peer_delayed_ack)
+ttest(tcp_peer_handshake)
 
 ttest(net_interface)
 
@@ -90,3 +106,6 @@ set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(wrapping_integers_speed_test)
+stest(congestion_control_speed_test)
+stest(tcp_sender_speed_test)
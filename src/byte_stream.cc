@@ -3,7 +3,48 @@
 
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ), buffer_( capacity, '\0' ) {}
+// Upper bound on the pieces returned by Reader::peek_iov (well below the kernel's IOV_MAX)
+static constexpr size_t MAX_IOV_PIECES = 64;
+
+ByteStream::ByteStream( uint64_t capacity, Storage storage ) : capacity_( capacity ), storage_( storage ) {}
+
+void ByteStream::shrink_to_fit()
+{
+  if ( storage_ == Storage::Chunked ) {
+    chunks_.shrink_to_fit();
+    return;
+  }
+
+  if ( buffer_.size() > bytes_pushed_ - bytes_popped_ ) {
+    resize_ring( bytes_pushed_ - bytes_popped_ );
+  }
+}
+
+void ByteStream::write_ring( string_view data )
+{
+  // grow the buffer (at least doubling it) when the data doesn't fit
+  const uint64_t buffered = bytes_pushed_ - bytes_popped_;
+  if ( buffered + data.size() > buffer_.size() ) {
+    resize_ring( min( capacity_, max( buffered + data.size(), 2 * buffer_.size() ) ) );
+  }
+
+  // write at the tail, wrapping around to the beginning of the buffer if necessary
+  const uint64_t tail = ( head_ + buffered ) % buffer_.size();
+  const uint64_t first_part = min( data.size(), buffer_.size() - tail );
+  copy( data.begin(), data.begin() + first_part, buffer_.begin() + tail );
+  copy( data.begin() + first_part, data.end(), buffer_.begin() );
+
+  bytes_pushed_ += data.size();
+}
+
+void ByteStream::resize_ring( uint64_t size )
+{
+  const auto [first, second] = reader().peek_both();
+  string resized( size, '\0' );
+  copy( second.begin(), second.end(), copy( first.begin(), first.end(), resized.begin() ) );
+  buffer_ = move( resized );
+  head_ = 0;
+}
 
 bool Writer::is_closed() const
 {
@@ -16,20 +57,37 @@ void Writer::push( string data )
   if ( data.size() > available_capacity() ) {
     data.resize( available_capacity() );
   }
+  if ( data.empty() ) {
+    return;
+  }
 
-  // move data to the beginning of the buffer if no enough space in the back
-  if ( capacity_ - tail_ < data.size() ) {
-    copy( buffer_.begin() + head_, buffer_.begin() + tail_, buffer_.begin() );
-    tail_ = tail_ - head_;
-    head_ = 0;
+  if ( storage_ == Storage::Chunked ) {
+    // don't let a mostly-empty read buffer pin its whole allocation while it sits in the stream
+    if ( data.capacity() > 2 * data.size() ) {
+      data.shrink_to_fit();
+    }
+    bytes_pushed_ += data.size();
+    chunks_.push_back( move( data ) );
+    return;
   }
 
-  copy( data.begin(), data.end(), buffer_.begin() + tail_ );
-  
-  tail_ += data.size();
-  bytes_pushed_ += data.size();
+  write_ring( data );
+}
 
-  return;
+void Writer::push_view( string_view data )
+{
+  data = data.substr( 0, available_capacity() );
+  if ( data.empty() ) {
+    return;
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    bytes_pushed_ += data.size();
+    chunks_.emplace_back( data );
+    return;
+  }
+
+  write_ring( data );
 }
 
 void Writer::close()
@@ -40,7 +98,7 @@ void Writer::close()
 
 uint64_t Writer::available_capacity() const
 {
-  return capacity_ - ( tail_ - head_ );
+  return capacity_ - ( bytes_pushed_ - bytes_popped_ );
 }
 
 uint64_t Writer::bytes_pushed() const
@@ -60,19 +118,77 @@ uint64_t Reader::bytes_popped() const
 
 string_view Reader::peek() const
 {
-  return string_view( buffer_.begin() + head_, buffer_.begin() + tail_ );
+  return peek_both().first;
+}
+
+pair<string_view, string_view> Reader::peek_both() const
+{
+  if ( storage_ == Storage::Chunked ) {
+    if ( chunks_.empty() ) {
+      return {};
+    }
+    const string_view second = chunks_.size() > 1 ? string_view { chunks_[1] } : string_view {};
+    return { string_view { chunks_.front() }.substr( chunk_skip_ ), second };
+  }
+
+  const string_view buffer { buffer_ };
+  const uint64_t first_part = min( bytes_buffered(), buffer_.size() - head_ );
+  return { buffer.substr( head_, first_part ), buffer.substr( 0, bytes_buffered() - first_part ) };
+}
+
+vector<string_view> Reader::peek_iov( uint64_t max_bytes ) const
+{
+  vector<string_view> ret;
+  const auto append = [&]( string_view piece ) {
+    piece = piece.substr( 0, max_bytes );
+    if ( not piece.empty() ) {
+      ret.push_back( piece );
+      max_bytes -= piece.size();
+    }
+  };
+
+  if ( storage_ == Storage::Chunked ) {
+    uint64_t skip = chunk_skip_;
+    for ( auto it = chunks_.begin(); it != chunks_.end() and max_bytes and ret.size() < MAX_IOV_PIECES; ++it ) {
+      append( string_view { *it }.substr( skip ) );
+      skip = 0;
+    }
+    return ret;
+  }
+
+  const auto [first, second] = peek_both();
+  append( first );
+  append( second );
+  return ret;
 }
 
 void Reader::pop( uint64_t len )
 {
   len = min( len, bytes_buffered() );
-  head_ += len;
+  if ( len == 0 ) {
+    return;
+  }
   bytes_popped_ += len;
 
+  if ( storage_ == Storage::Chunked ) {
+    while ( len ) {
+      const uint64_t to_pop_now = min( len, chunks_.front().size() - chunk_skip_ );
+      chunk_skip_ += to_pop_now;
+      len -= to_pop_now;
+      if ( chunk_skip_ == chunks_.front().size() ) {
+        chunks_.pop_front();
+        chunk_skip_ = 0;
+      }
+    }
+    return;
+  }
+
+  head_ = ( head_ + len ) % buffer_.size();
+
   return;
 }
 
 uint64_t Reader::bytes_buffered() const
 {
-  return tail_ - head_;
+  return bytes_pushed_ - bytes_popped_;
 }
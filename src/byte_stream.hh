@@ -1,8 +1,11 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 class Reader;
 class Writer;
@@ -10,7 +13,14 @@ class Writer;
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the ByteStream holds the bytes that have been pushed but not yet popped
+  enum class Storage
+  {
+    Ring,   // copy pushed bytes into a circular buffer that grows on demand up to `capacity` bytes
+    Chunked // take ownership of the pushed strings themselves (no byte copy)
+  };
+
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Ring );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -21,16 +31,26 @@ public:
   void set_error() { error_ = true; };       // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
 
+  void shrink_to_fit(); // Release buffer memory beyond what the currently buffered bytes need
+  Storage storage() const { return storage_; } // How does the stream hold its buffered bytes?
+
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
+  Storage storage_;
   bool error_ {};
   bool closed_ {};
-  std::string buffer_;
+  // circular buffer: buffered bytes start at `head_` and may wrap around past the end of `buffer_`
+  std::string buffer_ {};
   uint64_t head_ { 0 };
-  uint64_t tail_ { 0 };
+  // chunked storage: the pushed strings, with the first `chunk_skip_` bytes of the front one already popped
+  std::deque<std::string> chunks_ {};
+  uint64_t chunk_skip_ { 0 };
   uint64_t bytes_pushed_ { 0 };
   uint64_t bytes_popped_ { 0 };
+
+  void write_ring( std::string_view data ); // Copy data (which must fit) into the circular buffer
+  void resize_ring( uint64_t size );         // Reallocate the circular buffer, moving the buffered bytes first
 };
 
 class Writer : public ByteStream
@@ -39,6 +59,9 @@ public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
   void close();                  // Signal that the stream has reached its ending. Nothing more will be written.
 
+  // Same as push(), but copies the bytes from a view instead of taking ownership of a string
+  void push_view( std::string_view data );
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
@@ -47,7 +70,9 @@ public:
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
+  std::string_view peek() const; // Peek at the next contiguous bytes in the buffer (up to the wrap or chunk end)
+  std::pair<std::string_view, std::string_view> peek_both() const; // Peek at the next two contiguous pieces
+  std::vector<std::string_view> peek_iov( uint64_t max_bytes ) const; // Peek at up to `max_bytes`, for writev
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
@@ -0,0 +1,337 @@
+#include "congestion_controller.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+using namespace std;
+
+unique_ptr<CongestionController> CongestionController::make( CongestionControl algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case CongestionControl::Reno:
+      return make_unique<RenoController>( mss );
+    case CongestionControl::NewReno:
+      return make_unique<NewRenoController>( mss );
+    case CongestionControl::Cubic:
+      return make_unique<CubicController>( mss );
+    case CongestionControl::BBR:
+      return make_unique<BBRController>( mss );
+    case CongestionControl::None:
+      break;
+  }
+  return nullptr;
+}
+
+void RenoController::grow( uint64_t acked )
+{
+  if ( cwnd_ < ssthresh_ ) {
+    // slow start: one segment per acknowledgment
+    cwnd_ += min( acked, mss_ );
+    return;
+  }
+
+  // congestion avoidance: one segment per window acknowledged
+  bytes_acked_ += acked;
+  if ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void RenoController::on_ack( uint64_t ackno [[maybe_unused]], uint64_t acked, uint64_t now_ms [[maybe_unused]] )
+{
+  // Reno leaves fast recovery on the first new acknowledgment, deflating the window
+  if ( recover_.has_value() ) {
+    recover_.reset();
+    cwnd_ = ssthresh_;
+    return;
+  }
+
+  grow( acked );
+}
+
+void RenoController::on_duplicate_ack( uint64_t now_ms [[maybe_unused]] )
+{
+  // each duplicate means a segment has left the network, so inflate the window by one
+  if ( recover_.has_value() ) {
+    cwnd_ += mss_;
+  }
+}
+
+void RenoController::on_loss( LossSignal signal,
+                              uint64_t next_seqno,
+                              uint64_t in_flight,
+                              uint64_t now_ms [[maybe_unused]] )
+{
+  // only react once to the losses in a window
+  if ( signal == LossSignal::FastRetransmit and recover_.has_value() ) {
+    return;
+  }
+
+  ssthresh_ = max( in_flight / 2, 2 * mss_ );
+  bytes_acked_ = 0;
+
+  if ( signal == LossSignal::Timeout ) {
+    cwnd_ = mss_;
+    recover_.reset();
+  } else {
+    cwnd_ = ssthresh_ + 3 * mss_;
+    recover_ = next_seqno;
+  }
+}
+
+void NewRenoController::on_ack( uint64_t ackno, uint64_t acked, uint64_t now_ms )
+{
+  // partial acknowledgment: stay in fast recovery, deflating the window by the amount acknowledged
+  // (but adding back a segment for the retransmission this triggers)
+  if ( recover_.has_value() and ackno < *recover_ ) {
+    cwnd_ -= min( cwnd_, acked );
+    if ( acked >= mss_ ) {
+      cwnd_ += mss_;
+    }
+    cwnd_ = max( cwnd_, mss_ );
+    return;
+  }
+
+  RenoController::on_ack( ackno, acked, now_ms );
+}
+
+void CubicController::on_ack( uint64_t ackno, uint64_t acked, uint64_t now_ms )
+{
+  if ( recover_.has_value() ) {
+    if ( ackno < *recover_ ) {
+      return;
+    }
+    recover_.reset();
+  }
+
+  if ( cwnd_ < ssthresh_ ) {
+    cwnd_ += min( acked, mss_ );
+    return;
+  }
+
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  if ( not epoch_start_ms_.has_value() ) {
+    epoch_start_ms_ = now_ms;
+    if ( cwnd < w_max_ ) {
+      k_ = cbrt( ( w_max_ - cwnd ) / C );
+    } else {
+      k_ = 0;
+      w_max_ = cwnd;
+    }
+    w_est_ = cwnd;
+  }
+
+  // the cubic target, and what Reno would have reached by now (whichever is larger)
+  const double t = static_cast<double>( now_ms - *epoch_start_ms_ ) / 1000.0;
+  const double w_cubic = w_max_ + C * pow( t - k_, 3 );
+  w_est_ += 3 * ( 1 - BETA ) / ( 1 + BETA ) * static_cast<double>( acked ) / static_cast<double>( cwnd_ );
+  const double target = min( max( w_cubic, w_est_ ), 1.5 * cwnd );
+
+  // approach the target by (target - cwnd) / cwnd segments per segment acknowledged
+  if ( target > cwnd ) {
+    growth_ += ( target - cwnd ) / cwnd * static_cast<double>( acked );
+    const auto whole = static_cast<uint64_t>( growth_ );
+    cwnd_ += whole;
+    growth_ -= static_cast<double>( whole );
+  }
+}
+
+void CubicController::on_duplicate_ack( uint64_t now_ms [[maybe_unused]] ) {}
+
+void CubicController::on_loss( LossSignal signal,
+                               uint64_t next_seqno,
+                               uint64_t in_flight [[maybe_unused]],
+                               uint64_t now_ms [[maybe_unused]] )
+{
+  if ( signal == LossSignal::FastRetransmit and recover_.has_value() ) {
+    return;
+  }
+
+  // fast convergence: if the window didn't get back to where it was, release some bandwidth for other flows
+  const double cwnd = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  w_max_ = cwnd < w_max_ ? cwnd * ( 1 + BETA ) / 2 : cwnd;
+  ssthresh_ = max( static_cast<uint64_t>( static_cast<double>( cwnd_ ) * BETA ), 2 * mss_ );
+  epoch_start_ms_.reset();
+  growth_ = 0;
+
+  if ( signal == LossSignal::Timeout ) {
+    cwnd_ = mss_;
+    recover_.reset();
+  } else {
+    cwnd_ = ssthresh_;
+    recover_ = next_seqno;
+  }
+}
+
+namespace {
+// ProbeBW's pacing gains, one round trip each: probe for more bandwidth, drain what that queued, then cruise
+constexpr array<double, 8> PROBE_BW_GAINS { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+}
+
+double BBRController::pacing_gain() const
+{
+  switch ( mode_ ) {
+    case Mode::Startup:
+      return HIGH_GAIN;
+    case Mode::Drain:
+      return 1 / HIGH_GAIN;
+    case Mode::ProbeBW:
+      return PROBE_BW_GAINS.at( cycle_index_ );
+    case Mode::ProbeRTT:
+      break;
+  }
+  return 1;
+}
+
+double BBRController::cwnd_gain() const
+{
+  switch ( mode_ ) {
+    case Mode::Startup:
+    case Mode::Drain:
+      return HIGH_GAIN;
+    case Mode::ProbeBW:
+      return 2;
+    case Mode::ProbeRTT:
+      break;
+  }
+  return 1;
+}
+
+uint64_t BBRController::target_window( double gain ) const
+{
+  if ( not min_rtt_ms_.has_value() or bandwidth() == 0 ) {
+    return RenoController::INITIAL_WINDOW * mss_;
+  }
+  const double bdp = static_cast<double>( bandwidth() ) * static_cast<double>( *min_rtt_ms_ ) / 1000;
+  return max( static_cast<uint64_t>( gain * bdp ), MIN_WINDOW * mss_ );
+}
+
+optional<uint64_t> BBRController::pacing_rate() const
+{
+  return pacing_rate_;
+}
+
+void BBRController::on_ack( uint64_t ackno [[maybe_unused]], uint64_t acked, uint64_t now_ms [[maybe_unused]] )
+{
+  if ( mode_ == Mode::ProbeRTT ) {
+    cwnd_ = MIN_WINDOW * mss_;
+    return;
+  }
+
+  // grow towards the target like slow start until the pipe is full, then hold at the target
+  const uint64_t target = target_window( cwnd_gain() );
+  if ( filled_pipe_ ) {
+    cwnd_ = min( cwnd_ + acked, target );
+  } else if ( cwnd_ < target ) {
+    cwnd_ += acked;
+  }
+  cwnd_ = max( cwnd_, MIN_WINDOW * mss_ );
+}
+
+void BBRController::on_loss( LossSignal signal,
+                             uint64_t next_seqno [[maybe_unused]],
+                             uint64_t in_flight [[maybe_unused]],
+                             uint64_t now_ms [[maybe_unused]] )
+{
+  // the model doesn't react to individual losses, but after a timeout nothing is known to be in flight
+  if ( signal == LossSignal::Timeout ) {
+    cwnd_ = mss_;
+  }
+}
+
+void BBRController::on_rate_sample( const RateSample& sample, uint64_t now_ms )
+{
+  // a round trip ends when a segment sent after it began is acknowledged
+  const bool round_start = sample.prior_delivered >= next_round_delivered_;
+  if ( round_start ) {
+    ++round_;
+    next_round_delivered_ = sample.delivered;
+  }
+
+  // bottleneck bandwidth: the maximum delivery rate over the last few rounds (but always the latest sample)
+  if ( sample.interval_ms > 0 ) {
+    const uint64_t rate = ( sample.delivered - sample.prior_delivered ) * 1000 / sample.interval_ms;
+    while ( not bw_samples_.empty() and bw_samples_.back().second <= rate ) {
+      bw_samples_.pop_back();
+    }
+    bw_samples_.emplace_back( round_, rate );
+  }
+  while ( bw_samples_.size() > 1 and bw_samples_.front().first + BW_WINDOW_ROUNDS <= round_ ) {
+    bw_samples_.pop_front();
+  }
+
+  // round-trip propagation time: the minimum RTT, until it's gone too long without being seen again
+  const bool min_rtt_expired = min_rtt_ms_.has_value() and now_ms > min_rtt_stamp_ms_ + MIN_RTT_WINDOW_MS;
+  if ( sample.rtt_ms.has_value()
+       and ( not min_rtt_ms_.has_value() or *sample.rtt_ms <= *min_rtt_ms_ or min_rtt_expired ) ) {
+    min_rtt_ms_ = max<uint64_t>( *sample.rtt_ms, 1 );
+    min_rtt_stamp_ms_ = now_ms;
+  }
+
+  update_mode( sample, now_ms, round_start, min_rtt_expired );
+
+  // pace at the (scaled) bandwidth estimate; before that, pace the initial window over the first RTT.
+  // N.B. until the pipe is full, only ever raise the rate
+  optional<uint64_t> rate;
+  if ( bandwidth() > 0 ) {
+    rate = static_cast<uint64_t>( pacing_gain() * static_cast<double>( bandwidth() ) );
+  }
+  if ( not pacing_rate_.has_value() and min_rtt_ms_.has_value() ) {
+    const auto initial = static_cast<uint64_t>( HIGH_GAIN * static_cast<double>( cwnd_ ) ) * 1000 / *min_rtt_ms_;
+    rate = max( rate.value_or( 0 ), initial );
+  }
+  if ( rate.has_value() and ( filled_pipe_ or *rate > pacing_rate_.value_or( 0 ) ) ) {
+    pacing_rate_ = rate;
+  }
+}
+
+void BBRController::update_mode( const RateSample& sample, uint64_t now_ms, bool round_start, bool min_rtt_expired )
+{
+  switch ( mode_ ) {
+    case Mode::Startup:
+      // the pipe is full once the bandwidth estimate has grown less than 25% for three rounds
+      if ( round_start ) {
+        if ( bandwidth() >= full_bw_ + full_bw_ / 4 ) {
+          full_bw_ = bandwidth();
+          full_bw_rounds_ = 0;
+        } else if ( ++full_bw_rounds_ >= 3 ) {
+          filled_pipe_ = true;
+          mode_ = Mode::Drain;
+        }
+      }
+      break;
+
+    case Mode::Drain:
+      if ( sample.in_flight <= target_window( 1 ) ) {
+        mode_ = Mode::ProbeBW;
+        cycle_index_ = 2;
+        cycle_stamp_ms_ = now_ms;
+      }
+      break;
+
+    case Mode::ProbeBW:
+      if ( now_ms > cycle_stamp_ms_ + min_rtt_ms_.value_or( 0 ) ) {
+        cycle_index_ = ( cycle_index_ + 1 ) % PROBE_BW_GAINS.size();
+        cycle_stamp_ms_ = now_ms;
+      }
+      break;
+
+    case Mode::ProbeRTT:
+      if ( now_ms >= probe_rtt_done_ms_ ) {
+        min_rtt_stamp_ms_ = now_ms;
+        mode_ = filled_pipe_ ? Mode::ProbeBW : Mode::Startup;
+        cycle_stamp_ms_ = now_ms;
+      }
+      break;
+  }
+
+  if ( min_rtt_expired and mode_ != Mode::ProbeRTT ) {
+    mode_ = Mode::ProbeRTT;
+    probe_rtt_done_ms_ = now_ms + max( PROBE_RTT_MS, min_rtt_ms_.value_or( 0 ) );
+  }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+
+// Congestion control algorithms the TCPSender can use
+enum class CongestionControl
+{
+  None,    // only the receiver's window limits what's in flight
+  Reno,    // RFC 5681
+  NewReno, // RFC 6582
+  Cubic,   // RFC 9438
+  BBR,     // model-based, paced (after draft-cardwell-iccrg-bbr-congestion-control)
+};
+
+// How a loss was detected
+enum class LossSignal
+{
+  Timeout,        // the retransmission timer expired
+  FastRetransmit, // duplicate acknowledgments
+};
+
+// A delivery rate sample, taken when an acknowledgment arrives (see draft-cheng-iccrg-delivery-rate-estimation)
+struct RateSample
+{
+  uint64_t delivered {};             // sequence numbers delivered so far
+  uint64_t prior_delivered {};       // ... as of when the latest of the newly acknowledged segments was sent
+  uint64_t interval_ms {};           // time over which `delivered - prior_delivered` were delivered
+  std::optional<uint64_t> rtt_ms {}; // round-trip time of that segment (unless it was retransmitted)
+  uint64_t in_flight {};             // sequence numbers still outstanding
+};
+
+/*
+ * A CongestionController decides how many sequence numbers the TCPSender may have in flight
+ * (the congestion window), based on the acknowledgments and losses the sender reports to it.
+ * All sizes are in sequence numbers, and all times are the sender's cumulative milliseconds.
+ */
+class CongestionController
+{
+public:
+  virtual ~CongestionController() = default;
+
+  // The congestion window
+  virtual uint64_t window() const = 0;
+
+  // `acked` sequence numbers were newly acknowledged, cumulatively up to (absolute) `ackno`
+  virtual void on_ack( uint64_t ackno, uint64_t acked, uint64_t now_ms ) = 0;
+
+  // An acknowledgment arrived that acknowledged nothing new
+  virtual void on_duplicate_ack( uint64_t now_ms ) = 0;
+
+  // A loss was detected while `in_flight` sequence numbers were outstanding, and (absolute) `next_seqno` was
+  // the next sequence number to send
+  virtual void on_loss( LossSignal signal, uint64_t next_seqno, uint64_t in_flight, uint64_t now_ms ) = 0;
+
+  // A delivery rate sample was taken (after on_ack for the same acknowledgment)
+  virtual void on_rate_sample( const RateSample& sample [[maybe_unused]], uint64_t now_ms [[maybe_unused]] ) {}
+
+  // The rate to pace transmissions at, in bytes per second (or empty to send as fast as the window allows)
+  virtual std::optional<uint64_t> pacing_rate() const { return {}; }
+
+  // Construct the controller for `algorithm` (or none, for CongestionControl::None)
+  static std::unique_ptr<CongestionController> make( CongestionControl algorithm, uint64_t mss );
+};
+
+// Slow start, congestion avoidance and fast recovery from RFC 5681
+class RenoController : public CongestionController
+{
+public:
+  explicit RenoController( uint64_t mss ) : mss_( mss ), cwnd_( INITIAL_WINDOW * mss ) {}
+
+  uint64_t window() const override { return cwnd_; }
+  void on_ack( uint64_t ackno, uint64_t acked, uint64_t now_ms ) override;
+  void on_duplicate_ack( uint64_t now_ms ) override;
+  void on_loss( LossSignal signal, uint64_t next_seqno, uint64_t in_flight, uint64_t now_ms ) override;
+
+  static constexpr uint64_t INITIAL_WINDOW = 4; // in segments
+
+protected:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  uint64_t bytes_acked_ {}; // acknowledged during congestion avoidance, towards the next increase
+
+  // the (absolute) seqno that must be acknowledged to end fast recovery, if in fast recovery
+  std::optional<uint64_t> recover_ {};
+
+  // grow the window by slow start or congestion avoidance
+  void grow( uint64_t acked );
+};
+
+// Reno, but staying in fast recovery until every segment outstanding at the loss is acknowledged (RFC 6582)
+class NewRenoController : public RenoController
+{
+public:
+  using RenoController::RenoController;
+
+  void on_ack( uint64_t ackno, uint64_t acked, uint64_t now_ms ) override;
+};
+
+// Window growth as a cubic function of the time since the last loss (RFC 9438)
+class CubicController : public CongestionController
+{
+public:
+  explicit CubicController( uint64_t mss ) : mss_( mss ), cwnd_( RenoController::INITIAL_WINDOW * mss ) {}
+
+  uint64_t window() const override { return cwnd_; }
+  void on_ack( uint64_t ackno, uint64_t acked, uint64_t now_ms ) override;
+  void on_duplicate_ack( uint64_t now_ms ) override;
+  void on_loss( LossSignal signal, uint64_t next_seqno, uint64_t in_flight, uint64_t now_ms ) override;
+
+  static constexpr double C = 0.4;    // scaling constant, in segments per second cubed
+  static constexpr double BETA = 0.7; // multiplicative decrease factor
+
+private:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+
+  std::optional<uint64_t> epoch_start_ms_ {}; // when the current congestion avoidance stage began
+  double w_max_ {};                           // window before the last reduction, in segments
+  double k_ {};                               // seconds to grow back to w_max_
+  double w_est_ {};                           // what Reno would have reached, in segments
+  double growth_ {};                          // fractional window increase not yet applied, in bytes
+  std::optional<uint64_t> recover_ {};
+};
+
+// Paces at the estimated bottleneck bandwidth, and keeps about one bandwidth-delay product in flight
+class BBRController : public CongestionController
+{
+public:
+  explicit BBRController( uint64_t mss ) : mss_( mss ), cwnd_( RenoController::INITIAL_WINDOW * mss ) {}
+
+  uint64_t window() const override { return cwnd_; }
+  void on_ack( uint64_t ackno, uint64_t acked, uint64_t now_ms ) override;
+  void on_duplicate_ack( uint64_t now_ms [[maybe_unused]] ) override {}
+  void on_loss( LossSignal signal, uint64_t next_seqno, uint64_t in_flight, uint64_t now_ms ) override;
+  void on_rate_sample( const RateSample& sample, uint64_t now_ms ) override;
+  std::optional<uint64_t> pacing_rate() const override;
+
+  enum class Mode
+  {
+    Startup,  // double the sending rate each round until the bandwidth estimate stops growing
+    Drain,    // drain the queue Startup built up
+    ProbeBW,  // cycle the pacing gain around 1 to probe for more bandwidth
+    ProbeRTT, // briefly shrink the window to measure the round-trip time without a queue
+  };
+  Mode mode() const { return mode_; }
+
+  static constexpr double HIGH_GAIN = 2.885;           // 2/ln(2): the smallest gain that doubles the rate per round
+  static constexpr uint64_t BW_WINDOW_ROUNDS = 10;     // how long the bandwidth estimate remembers a sample
+  static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000; // how long the min RTT estimate lasts without a new low
+  static constexpr uint64_t PROBE_RTT_MS = 200;        // how long ProbeRTT lasts (at least)
+  static constexpr uint64_t MIN_WINDOW = 4;            // in segments
+
+private:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  Mode mode_ { Mode::Startup };
+  bool filled_pipe_ {};
+  std::optional<uint64_t> pacing_rate_ {};
+
+  // windowed maximum of the delivery rate (bytes per second), as (round, rate) with decreasing rates
+  std::deque<std::pair<uint64_t, uint64_t>> bw_samples_ {};
+  std::optional<uint64_t> min_rtt_ms_ {};
+  uint64_t min_rtt_stamp_ms_ {};
+
+  // round-trip counting
+  uint64_t round_ {};
+  uint64_t next_round_delivered_ {};
+
+  // Startup's check for a full pipe
+  uint64_t full_bw_ {};
+  uint64_t full_bw_rounds_ {};
+
+  size_t cycle_index_ {};
+  uint64_t cycle_stamp_ms_ {};
+  uint64_t probe_rtt_done_ms_ {};
+
+  uint64_t bandwidth() const { return bw_samples_.empty() ? 0 : bw_samples_.front().second; }
+  double pacing_gain() const;
+  double cwnd_gain() const;
+  // bandwidth-delay product, scaled by `gain`
+  uint64_t target_window( double gain ) const;
+  void update_mode( const RateSample& sample, uint64_t now_ms, bool round_start, bool min_rtt_expired );
+};
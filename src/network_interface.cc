@@ -42,7 +42,6 @@ void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Addre
   // sent arp request if: entry not present
   //
   // waiting-for-reply timeout entres will be cleared in tick()
-  // assert( curr_time_ > mapping->second.time );
   if ( mapping == mapping_cache_.end() ) {
     // NOTE: cache datagram before send arp req, or else the test would fail (nothing is cached)
     datagrams_cached_.push_back( { dgram, next_hop } );
@@ -81,36 +80,30 @@ void NetworkInterface::recv_frame( const EthernetFrame& frame )
   }
 
   // refresh or add cache entry
-  auto mapping = mapping_cache_.find( ip_numeric );
-  if ( mapping != mapping_cache_.end() ) {
-    // refresh
-    auto entry = CacheTableEntry( frame.header.src, true, curr_time_ );
-    mapping->second = entry;
-  } else {
-    // add
-    auto entry = CacheTableEntry( frame.header.src, true, curr_time_ );
-    mapping_cache_.insert( {ip_numeric, entry });
-  }
+  set_mapping( ip_numeric, frame.header.src, true );
   send_cached();
 }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick( const size_t ms_since_last_tick )
 {
-  curr_time_ += ms_since_last_tick;
-
-  // expire outdated mapping cache entries
-  // TODO: can we use ordered_map to boost time-based / ip-based query
-  for ( auto it = mapping_cache_.begin(); it != mapping_cache_.end(); ) {
-    // assert( curr_time_ > it->second.time );
-    auto time_elapsed = curr_time_ - it->second.time;
-    if ( ( it->second.valid && time_elapsed >= ENTRY_VALID_MS )
-         || ( !it->second.valid && time_elapsed >= ARP_RESENT_COOLDOWN_MS ) ) {
-      it = mapping_cache_.erase( it );
-    } else {
-      ++it;
-    }
+  // expire outdated mapping cache entries (only those whose time is up are visited)
+  timers_.advance( ms_since_last_tick,
+                   [this]( uint64_t ip_numeric ) { mapping_cache_.erase( static_cast<uint32_t>( ip_numeric ) ); } );
+}
+
+void NetworkInterface::set_mapping( uint32_t ip_numeric, const EthernetAddress& eth_addr, bool valid )
+{
+  auto mapping = mapping_cache_.find( ip_numeric );
+  if ( mapping != mapping_cache_.end() ) {
+    // refresh
+    timers_.cancel( mapping->second.expiry );
+    mapping->second = CacheTableEntry( eth_addr, valid );
+  } else {
+    // add
+    mapping = mapping_cache_.insert( { ip_numeric, CacheTableEntry( eth_addr, valid ) } ).first;
   }
+  mapping->second.expiry = timers_.arm( valid ? ENTRY_VALID_MS : ARP_RESENT_COOLDOWN_MS, ip_numeric );
 }
 
 void NetworkInterface::tx_ipv4( const InternetDatagram& dgram, const EthernetAddress& eth_addr )
@@ -122,12 +115,12 @@ void NetworkInterface::tx_ipv4( const InternetDatagram& dgram, const EthernetAdd
 
 void NetworkInterface::tx_arp_request( uint32_t ip_numeric )
 {
+  // NOTE: record the pending request first: the reply may arrive (and be learned) before transmit() returns
+  set_mapping( ip_numeric, ZERO_ETHERNET_ADDRESS, false );
+
   auto arp_msg = make_arp( ARPMessage::OPCODE_REQUEST, ZERO_ETHERNET_ADDRESS, ip_numeric );
   auto eth_frame = make_frame( ETHERNET_BROADCAST, EthernetHeader::TYPE_ARP, arp_msg );
   transmit( eth_frame );
-
-  auto entry = CacheTableEntry( ZERO_ETHERNET_ADDRESS, false, curr_time_ );
-  mapping_cache_.insert( { ip_numeric, entry } );
 }
 
 void NetworkInterface::tx_arp_reply( const EthernetAddress& eth_addr, const uint32_t ip_numeric ) {
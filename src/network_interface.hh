@@ -12,6 +12,7 @@
 #include "ethernet_frame.hh"
 #include "ethernet_header.hh"
 #include "ipv4_datagram.hh"
+#include "timer_wheel.hh"
 
 // A "network interface" that connects IP (the internet layer, or network layer)
 // with Ethernet (the network access layer, or link layer).
@@ -98,20 +99,20 @@ private:
     // true if received arp reply
     // flase if not yet
     bool valid;
-    // time of entry last used if valid is true
-    // time of arp request sent if valid is false
-    size_t time;
+    // removes the entry, ENTRY_VALID_MS after it was learned if valid is true,
+    // or ARP_RESENT_COOLDOWN_MS after the arp request was sent if valid is false
+    TimerWheel::Handle expiry {};
 
-    CacheTableEntry( const EthernetAddress& eth_addr_, bool valid_, size_t time_ ) {
+    CacheTableEntry( const EthernetAddress& eth_addr_, bool valid_ ) {
       eth_addr = eth_addr_;
       valid = valid_;
-      time = time_;
     }
   };
   // ip to ethernet address mapping
   std::unordered_map<uint32_t, CacheTableEntry> mapping_cache_ {};
 
-  size_t curr_time_ { 0 };
+  // expiry of mapping cache entries (tagged with the ip)
+  TimerWheel timers_ {};
   const size_t ENTRY_VALID_MS { 30 * 1000 };
   const size_t ARP_RESENT_COOLDOWN_MS { 5 * 1000 };
 
@@ -119,6 +120,8 @@ private:
   void tx_ipv4( const InternetDatagram& dgram, const EthernetAddress& eth_addr );
   void tx_arp_request( uint32_t ip_numeric );
   void tx_arp_reply( const EthernetAddress& eth_addr, const uint32_t ip_numeric );
+  // add or refresh a mapping cache entry, restarting its expiry
+  void set_mapping( uint32_t ip_numeric, const EthernetAddress& eth_addr, bool valid );
   // check if there are send-able dgrams cached, and send them
   void send_cached();
 
@@ -1,8 +1,11 @@
 #include "reassembler.hh"
 #include <algorithm>
 #include <cstdint>
+#include <iterator>
+#include <string_view>
 #include <sys/types.h>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -25,39 +28,72 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
     return;
   }
 
-  auto accepting_begin_it = data.cbegin();
-  auto accepting_end_it = data.cend();
+  // fast path: the next bytes with nothing stored, so no reassembly is needed
+  if ( first_index == expecting_ and bytes_pending_ == 0 ) {
+    ++fast_path_inserts_;
+    const uint64_t accepted_size = min( past_end_index, first_unacceptable_index ) - first_index;
+    if ( retain_segments_ ) {
+      data.resize( accepted_size );
+      output_.writer().push( move( data ) );
+    } else {
+      output_.writer().push_view( string_view { data }.substr( 0, accepted_size ) );
+    }
+    expecting_ += accepted_size;
+    if ( expecting_ == past_last_index_ ) {
+      output_.writer().close();
+    }
+    return;
+  }
+
+  if ( retain_segments_ ) {
+    // trim unacceptable data (free for a string) and leave the rest of the trimming to insert_retained()
+    data.resize( min( past_end_index, first_unacceptable_index ) - first_index );
+    insert_retained( first_index, move( data ) );
+    return;
+  }
+
+  string_view accepted { data };
   // trim accepted data
   if ( first_index < expecting_ ) {
-    accepting_begin_it += expecting_ - first_index;
+    accepted.remove_prefix( expecting_ - first_index );
     first_index = expecting_;
   }
   // trim unacceptable data
   if ( past_end_index > first_unacceptable_index ) {
-    accepting_end_it -= ( past_end_index - first_unacceptable_index );
+    accepted.remove_suffix( past_end_index - first_unacceptable_index );
     past_end_index = first_unacceptable_index;
   }
+  if ( accepted.empty() ) {
+    return;
+  }
+
+  // grow buffer (at least doubling it) to hold the data
+  if ( buffer_.size() < past_end_index - expecting_ ) {
+    resize_window( min( first_unacceptable_index - expecting_,
+                        max( past_end_index - expecting_, 2 * static_cast<uint64_t>( buffer_.size() ) ) ) );
+  }
 
-  // copy data to buffer
-  std::copy( accepting_begin_it, accepting_end_it, buffer_.begin() + first_index - expecting_ );
+  // copy data to buffer, wrapping around to its beginning if necessary
+  const uint64_t start = ( window_start_ + first_index - expecting_ ) % buffer_.size();
+  const uint64_t before_wrap = min( static_cast<uint64_t>( accepted.size() ), buffer_.size() - start );
+  std::copy( accepted.begin(), accepted.begin() + before_wrap, buffer_.begin() + start );
+  std::copy( accepted.begin() + before_wrap, accepted.end(), buffer_.begin() );
 
   // maintain segment location info
-  auto seg = std::make_pair(first_index, past_end_index - 1 );
-  auto it = std::lower_bound( seg_locs_.begin(), seg_locs_.end(), seg );
-  seg_locs_.insert( it, seg );
-  merge_locs();
-
-  // push if possible
-  if ( expecting_ == seg_locs_.front().first ) {
-    auto pushing_size = seg_locs_.front().second - expecting_ + 1;
-
-    output_.writer().push( buffer_.substr(0, pushing_size ) );
-    seg_locs_.pop_front();
-    if ( !seg_locs_.empty() ) {
-      std::copy( buffer_.cbegin() + ( seg_locs_.front().first - expecting_ ),
-                 buffer_.cbegin() + ( seg_locs_.back().second - expecting_ + 1 ),
-                 buffer_.begin() + ( seg_locs_.front().first - expecting_ - pushing_size ) );
-    }
+  add_loc( first_index, past_end_index - 1 );
+
+  // push if possible (straight from the window, no sliding)
+  const auto front = seg_locs_.begin();
+  if ( expecting_ == front->first ) {
+    const uint64_t pushing_size = front->second - expecting_ + 1;
+    const string_view window { buffer_ };
+    const uint64_t pushing_before_wrap = min( pushing_size, buffer_.size() - window_start_ );
+
+    output_.writer().push_view( window.substr( window_start_, pushing_before_wrap ) );
+    output_.writer().push_view( window.substr( 0, pushing_size - pushing_before_wrap ) );
+    window_start_ = ( window_start_ + pushing_size ) % buffer_.size();
+    bytes_pending_ -= pushing_size;
+    seg_locs_.erase( front );
 
     expecting_ += pushing_size;
     if ( expecting_ == past_last_index_ ) {
@@ -66,33 +102,147 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
   }
 }
 
-uint64_t Reassembler::bytes_pending() const
+void Reassembler::insert_retained( uint64_t first_index, string data )
 {
-  uint64_t res = 0;
-  for ( const auto &loc : seg_locs_ ) {
-    res += loc.second - loc.first + 1;
+  const uint64_t past_end_index = first_index + data.size();
+  uint64_t cursor = max( first_index, expecting_ );
+
+  // skip past a preceding segment that already covers the start of the data
+  auto it = segments_.upper_bound( cursor );
+  if ( it != segments_.begin() ) {
+    const auto prev = std::prev( it );
+    cursor = max( cursor, prev->first + prev->second.size() );
   }
 
-  return res;
+  // store each gap between the existing segments that the data covers
+  while ( cursor < past_end_index ) {
+    const uint64_t gap_end = ( it == segments_.end() ) ? past_end_index : min( it->first, past_end_index );
+    if ( cursor < gap_end ) {
+      // N.B. the common case (no overlap at all) moves the string in without copying it
+      string piece = ( cursor == first_index and gap_end == past_end_index )
+                       ? move( data )
+                       : data.substr( cursor - first_index, gap_end - cursor );
+      bytes_pending_ += piece.size();
+      segments_.emplace_hint( it, cursor, move( piece ) );
+    }
+    if ( it == segments_.end() ) {
+      break;
+    }
+    cursor = max( cursor, it->first + it->second.size() );
+    ++it;
+  }
+
+  // push the contiguous segments at the front
+  while ( not segments_.empty() and segments_.begin()->first == expecting_ ) {
+    auto front = segments_.extract( segments_.begin() );
+    expecting_ += front.mapped().size();
+    bytes_pending_ -= front.mapped().size();
+    output_.writer().push( move( front.mapped() ) );
+  }
+
+  if ( expecting_ == past_last_index_ ) {
+    output_.writer().close();
+  }
 }
 
-void Reassembler::merge_locs()
+uint64_t Reassembler::bytes_pending() const
 {
-  if ( seg_locs_.size() <= 1 ) {
-    return;
+  return bytes_pending_;
+}
+
+uint64_t Reassembler::fast_path_inserts() const
+{
+  return fast_path_inserts_;
+}
+
+vector<pair<uint64_t, uint64_t>> Reassembler::pending_ranges( uint64_t index, size_t max_ranges ) const
+{
+  vector<pair<uint64_t, uint64_t>> ranges;
+  if ( max_ranges == 0 ) {
+    return ranges;
   }
 
-  auto i = seg_locs_.begin();
-  while ( i != seg_locs_.end() ) {
-    auto j = std::next( i );
-    if ( j == seg_locs_.end() )
-      break;
+  // the range containing `index` (if any) goes first, and the walk in order then skips it
+  if ( not retain_segments_ ) {
+    if ( auto loc = seg_locs_.upper_bound( index ); loc != seg_locs_.begin() and prev( loc )->second >= index ) {
+      ranges.emplace_back( prev( loc )->first, prev( loc )->second + 1 );
+    }
+    for ( auto loc = seg_locs_.begin(); loc != seg_locs_.end() and ranges.size() < max_ranges; ++loc ) {
+      if ( ranges.empty() or loc->first != ranges.front().first ) {
+        ranges.emplace_back( loc->first, loc->second + 1 );
+      }
+    }
+    return ranges;
+  }
 
-    if ( i->second + 1 >= j->first ) {
-      i->second = std::max( i->second, j->second );
-      seg_locs_.erase( j );
-    } else {
-      ++i;
+  // retained segments don't overlap, but may be adjacent, so a range is a run of adjacent segments
+  const auto past_end = []( auto seg ) { return seg->first + seg->second.size(); };
+  const auto run_from = [&]( auto seg ) {
+    uint64_t past_last = past_end( seg );
+    for ( ++seg; seg != segments_.end() and seg->first == past_last; ++seg ) {
+      past_last = past_end( seg );
+    }
+    return pair { past_last, seg };
+  };
+
+  if ( auto seg = segments_.upper_bound( index ); seg != segments_.begin() and past_end( prev( seg ) ) > index ) {
+    auto start = prev( seg );
+    while ( start != segments_.begin() and past_end( prev( start ) ) == start->first ) {
+      --start;
+    }
+    ranges.emplace_back( start->first, run_from( start ).first );
+  }
+  for ( auto seg = segments_.begin(); seg != segments_.end() and ranges.size() < max_ranges; ) {
+    const auto [past_last, next_run] = run_from( seg );
+    if ( ranges.empty() or seg->first != ranges.front().first ) {
+      ranges.emplace_back( seg->first, past_last );
     }
+    seg = next_run;
   }
-}
\ No newline at end of file
+  return ranges;
+}
+
+void Reassembler::shrink_to_fit()
+{
+  resize_window( seg_locs_.empty() ? 0 : seg_locs_.rbegin()->second - expecting_ + 1 );
+  output_.shrink_to_fit();
+}
+
+void Reassembler::resize_window( uint64_t size )
+{
+  string resized( size, '\0' );
+  const uint64_t kept = min( size, static_cast<uint64_t>( buffer_.size() ) );
+  const uint64_t kept_before_wrap = min( kept, buffer_.size() - window_start_ );
+  const auto window_begin = buffer_.cbegin() + window_start_;
+  std::copy( window_begin, window_begin + kept_before_wrap, resized.begin() );
+  std::copy( buffer_.cbegin(), buffer_.cbegin() + ( kept - kept_before_wrap ), resized.begin() + kept_before_wrap );
+  buffer_ = move( resized );
+  window_start_ = 0;
+}
+
+void Reassembler::add_loc( uint64_t first, uint64_t last )
+{
+  // merge with the preceding segment, if it overlaps or touches
+  auto it = seg_locs_.upper_bound( first );
+  if ( it != seg_locs_.begin() ) {
+    const auto prev = std::prev( it );
+    if ( prev->second + 1 >= first ) {
+      if ( prev->second >= last ) {
+        return; // already stored
+      }
+      first = prev->first;
+      bytes_pending_ -= prev->second - prev->first + 1;
+      it = seg_locs_.erase( prev );
+    }
+  }
+
+  // absorb the following segments that overlap or touch
+  while ( it != seg_locs_.end() && it->first <= last + 1 ) {
+    last = std::max( last, it->second );
+    bytes_pending_ -= it->second - it->first + 1;
+    it = seg_locs_.erase( it );
+  }
+
+  seg_locs_.emplace_hint( it, first, last );
+  bytes_pending_ += last - first + 1;
+}
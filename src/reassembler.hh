@@ -3,16 +3,20 @@
 #include "byte_stream.hh"
 #include <cstdint>
 #include <sys/types.h>
+#include <map>
 #include <utility>
-#include <list>
+#include <vector>
 
 class Reassembler
 {
 public:
   // Construct Reassembler to write into given ByteStream.
+  // If the output uses chunked storage, the Reassembler keeps the inserted strings themselves and moves them
+  // into the output once they are contiguous (so an in-order payload reaches the reader without a copy).
   explicit Reassembler( ByteStream&& output )
     : output_( std::move( output ) )
-    , buffer_( output_.writer().available_capacity(), '0' )
+    , retain_segments_( output_.storage() == ByteStream::Storage::Chunked )
+    , buffer_()
     , seg_locs_()
   {}
 
@@ -41,6 +45,16 @@ public:
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
 
+  // How many insertions took the fast path (in-order data with nothing stored, pushed straight to the output)?
+  uint64_t fast_path_inserts() const;
+
+  // Up to `max_ranges` of the stream index ranges [first, past_last) of the stored bytes: the one containing
+  // `index` (if any) first, then the others in order
+  std::vector<std::pair<uint64_t, uint64_t>> pending_ranges( uint64_t index, size_t max_ranges ) const;
+
+  // Release buffer memory (here and in the output stream) beyond what the stored bytes need
+  void shrink_to_fit();
+
   // Access output stream reader
   Reader& reader() { return output_.reader(); }
   const Reader& reader() const { return output_.reader(); }
@@ -50,11 +64,29 @@ public:
 
 private:
   ByteStream output_; // the Reassembler writes to this ByteStream
+  bool retain_segments_;
 
+  // retained storage: non-overlapping substrings, keyed by the stream index of their first byte
+  std::map<uint64_t, std::string> segments_ {};
+
+  // copied storage: a circular window over stream indices [expecting_, expecting_ + buffer_.size()), starting at `window_start_`;
+  // grows on demand, up to the output's available capacity
   std::string buffer_;
-  std::list<std::pair<uint64_t, uint64_t>> seg_locs_;
+  uint64_t window_start_ = 0;
+  // stored segments as disjoint, non-adjacent [first, last] index ranges, keyed by first index
+  std::map<uint64_t, uint64_t> seg_locs_;
+  uint64_t bytes_pending_ = 0;
   uint64_t expecting_ = 0;
   uint64_t past_last_index_ = UINT64_MAX;
+  uint64_t fast_path_inserts_ = 0;
+
+  // record [first, last] as stored, merging it with any overlapping or adjacent segments
+  void add_loc( uint64_t first, uint64_t last );
+
+  // reallocate the window with `size` bytes, moving its contents to the start
+  void resize_window( uint64_t size );
 
-  void merge_locs();
+  // store the parts of `data` (starting at `first_index`, and inside the window) not already stored,
+  // then move any now-contiguous segments into the output
+  void insert_retained( uint64_t first_index, std::string data );
 };
@@ -0,0 +1,132 @@
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity ) : capacity_( capacity ), buffer_( capacity, '\0' )
+{
+  space_event_.notify();
+}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  const uint64_t tail = bytes_pushed_.load( memory_order_relaxed );
+  const uint64_t head = bytes_popped_.load( memory_order_acquire );
+  data = data.substr( 0, capacity_ - ( tail - head ) );
+  if ( data.empty() ) {
+    return 0;
+  }
+
+  // write at the tail, wrapping around to the beginning of the buffer if necessary
+  const uint64_t start = tail % capacity_;
+  const uint64_t first_part = min( data.size(), capacity_ - start );
+  copy( data.begin(), data.begin() + first_part, buffer_.begin() + start );
+  copy( data.begin() + first_part, data.end(), buffer_.begin() );
+
+  // N.B. seq_cst store then load (and the reverse in pop()): if the consumer had caught up with `tail`
+  // and may be asleep, we see it here; otherwise it sees the new bytes before it sleeps
+  bytes_pushed_.store( tail + data.size(), memory_order_seq_cst );
+  if ( bytes_popped_.load( memory_order_seq_cst ) == tail ) {
+    data_event_.notify();
+  }
+
+  return data.size();
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true, memory_order_release );
+  data_event_.notify();
+}
+
+bool SPSCByteStream::is_closed() const
+{
+  return closed_.load( memory_order_acquire );
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  return capacity_ - bytes_buffered();
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return bytes_pushed_.load( memory_order_acquire );
+}
+
+bool SPSCByteStream::prepare_wait_for_space()
+{
+  const auto full = [&] { return available_capacity() == 0 and not has_error(); };
+  if ( not full() ) {
+    return false;
+  }
+  space_event_.clear();
+  return full();
+}
+
+pair<string_view, string_view> SPSCByteStream::peek_both() const
+{
+  const uint64_t buffered = bytes_buffered();
+  if ( buffered == 0 ) {
+    return {};
+  }
+
+  const string_view buffer { buffer_ };
+  const uint64_t start = bytes_popped_.load( memory_order_relaxed ) % capacity_;
+  const uint64_t first_part = min( buffered, capacity_ - start );
+  return { buffer.substr( start, first_part ), buffer.substr( 0, buffered - first_part ) };
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  len = min( len, bytes_buffered() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  const uint64_t head = bytes_popped_.load( memory_order_relaxed );
+  bytes_popped_.store( head + len, memory_order_seq_cst );
+  if ( bytes_pushed_.load( memory_order_seq_cst ) - head == capacity_ ) {
+    space_event_.notify();
+  }
+}
+
+bool SPSCByteStream::prepare_wait_for_data()
+{
+  const auto idle = [&] { return bytes_buffered() == 0 and not is_closed() and not has_error(); };
+  if ( not idle() ) {
+    return false;
+  }
+  data_event_.clear();
+  return idle();
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  // N.B. check `closed_` first: everything pushed before close() is visible once it reads true
+  return is_closed() and bytes_buffered() == 0;
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  const uint64_t head = bytes_popped_.load( memory_order_acquire );
+  return bytes_pushed_.load( memory_order_acquire ) - head;
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return bytes_popped_.load( memory_order_acquire );
+}
+
+void SPSCByteStream::set_error()
+{
+  error_.store( true, memory_order_release );
+  data_event_.notify();
+  space_event_.notify();
+}
+
+bool SPSCByteStream::has_error() const
+{
+  return error_.load( memory_order_acquire );
+}
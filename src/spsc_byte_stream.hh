@@ -0,0 +1,72 @@
+#pragma once
+
+#include "eventfd.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ * A ByteStream that one producer thread and one consumer thread can share without locks.
+ *
+ * The producer calls push(), close() and available_capacity(); the consumer calls peek_both(), pop(),
+ * bytes_buffered() and is_finished(). The buffer is a fixed circular buffer of `capacity` bytes, and each
+ * side owns one counter (bytes pushed / bytes popped), kept on separate cache lines.
+ *
+ * Each side can sleep in poll() on an eventfd. Only transitions write to them, not every push or pop:
+ * data_event() becomes readable when the stream goes from empty to non-empty (or is closed), and
+ * space_event() when it goes from full to not full (it starts out readable). A side that finds nothing
+ * to do calls prepare_wait_for_data() or prepare_wait_for_space(), which clears the event and looks
+ * once more, and only sleeps if that returns true.
+ */
+class SPSCByteStream
+{
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  // Producer side
+  uint64_t push( std::string_view data ); // Push as much of `data` as fits; returns the number of bytes pushed
+  void close();                           // Signal that the stream has reached its ending
+  bool is_closed() const;                 // Has the stream been closed?
+  uint64_t available_capacity() const;    // How many bytes can be pushed right now?
+  uint64_t bytes_pushed() const;          // Total number of bytes cumulatively pushed
+  bool prepare_wait_for_space();          // Clear space_event() if full; true if still full
+
+  // Consumer side
+  std::pair<std::string_view, std::string_view> peek_both() const; // Peek at all buffered bytes, split at the wrap
+  void pop( uint64_t len );                                        // Remove `len` bytes from the buffer
+  bool is_finished() const;                                        // Is the stream closed and fully popped?
+  uint64_t bytes_buffered() const;                                 // Bytes pushed and not yet popped
+  uint64_t bytes_popped() const;                                   // Total number of bytes cumulatively popped
+  bool prepare_wait_for_data();                                    // Clear data_event() if idle; true if still idle
+
+  void set_error();       // Signal that the stream suffered an error
+  bool has_error() const; // Has the stream had an error?
+
+  // Wakeup descriptors for the consumer and the producer
+  EventFD& data_event() { return data_event_; }
+  EventFD& space_event() { return space_event_; }
+
+  // Shared between threads, so neither copyable nor movable
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  SPSCByteStream( SPSCByteStream&& other ) = delete;
+  SPSCByteStream& operator=( SPSCByteStream&& other ) = delete;
+  ~SPSCByteStream() = default;
+
+private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  uint64_t capacity_;
+  std::string buffer_;
+  std::atomic<bool> closed_ {};
+  std::atomic<bool> error_ {};
+  EventFD data_event_ {};
+  EventFD space_event_ {};
+
+  alignas( CACHE_LINE_SIZE ) std::atomic<uint64_t> bytes_pushed_ { 0 }; // written only by the producer
+  alignas( CACHE_LINE_SIZE ) std::atomic<uint64_t> bytes_popped_ { 0 }; // written only by the consumer
+};
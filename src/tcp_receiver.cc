@@ -1,5 +1,6 @@
 #include "tcp_receiver.hh"
 #include "wrapping_integers.hh"
+#include <algorithm>
 #include <cstdint>
 #include <optional>
 
@@ -7,33 +8,73 @@ using namespace std;
 
 void TCPReceiver::receive( TCPSenderMessage message )
 {
-  if ( message.SYN )
+  if ( message.SYN ) {
     isn_ = std::make_optional( message.seqno );
+    sack_permitted_ = message.SACK_permitted;
+    peer_window_scale_ = message.window_scale.has_value();
+    ts_recent_ = message.timestamp;
+  }
   if ( message.RST )
     reader().set_error();
   if ( !isn_.has_value() )
     return;
 
+  // NOTE: PAWS: a segment stamped earlier than the latest in-order one is an old duplicate, even if its
+  // sequence numbers (after wrapping around) look new, so drop it (the peer still acknowledges it)
+  if ( !message.SYN && !message.RST && ts_recent_.has_value() && message.timestamp.has_value()
+       && static_cast<int32_t>( *message.timestamp - *ts_recent_ ) < 0 ) {
+    paws_rejected_ += 1;
+    return;
+  }
+
   // if current message doesn't have SYN, then SYN must have been received, so minus 1
-  reassembler_.insert(
-      message.SYN ? 0 : message.seqno.unwrap( isn_.value(), writer().bytes_pushed() ) - 1,
-      message.payload,
-      message.FIN
-  );
+  const uint64_t first_index = message.SYN ? 0 : message.seqno.unwrap( isn_.value(), writer().bytes_pushed() ) - 1;
+
+  // NOTE: echo the timestamp of the segment that (next) advances the ackno, not that of out-of-order ones
+  if ( ts_recent_.has_value() && message.timestamp.has_value() && first_index <= writer().bytes_pushed() )
+    ts_recent_ = message.timestamp;
+
+  const bool has_payload = !message.payload.empty();
+  reassembler_.insert( first_index, std::move( message.payload ).release(), message.FIN );
+
+  // NOTE: remember where the latest out-of-order data went, so its SACK block can be reported first
+  if ( has_payload && first_index > writer().bytes_pushed() )
+    latest_out_of_order_index_ = first_index;
+}
+
+optional<Wrap32> TCPReceiver::ackno() const
+{
+  // ackno = SYN + stream expecting index + FIN
+  // if isn_.has_value() is true, then SYN must have been received, however FIN is unknown
+  if ( !isn_.has_value() )
+    return nullopt;
+  return isn_.value() + static_cast<uint32_t>( 1 + writer().bytes_pushed() + writer().is_closed() );
 }
 
 TCPReceiverMessage TCPReceiver::send() const
 {
-  return {
-      isn_.has_value() 
-          // ackno = SYN + stream expecting index + FIN
-          // if isn_.has_value() is true, then SYN must have been received, however FIN is unknown
-          ? isn_.value() + static_cast<uint32_t>( 1 + writer().bytes_pushed() + writer().is_closed() ) 
-          : static_cast<std::optional<Wrap32>>( std::nullopt ),
-      writer().available_capacity() > static_cast<uint64_t>( UINT16_MAX )
-          // note that uint64_t capacity may exceed uint16_t upper limit
-          ? static_cast<uint16_t>( UINT16_MAX ) 
-          : static_cast<uint16_t>( writer().available_capacity() ),
+  // NOTE: with window scaling negotiated, the window can cover the 16-bit field shifted by our scale
+  const uint64_t max_window
+      = window_scale_.has_value() && peer_window_scale_ ? uint64_t { UINT16_MAX } << *window_scale_ : UINT16_MAX;
+  TCPReceiverMessage msg {
+      ackno(),
+      // note that uint64_t capacity may exceed the window's upper limit
+      static_cast<uint32_t>( min( writer().available_capacity(), max_window ) ),
       writer().has_error()
   };
+  msg.timestamp_echo = ts_recent_;
+
+  if ( !sack_permitted_ || reassembler_.bytes_pending() == 0 )
+    return msg;
+
+  // NOTE: stream index i is sequence number i + 1 (after the SYN)
+  const size_t max_sack_blocks = ts_recent_.has_value() ? TCPReceiverMessage::MAX_SACK_BLOCKS_WITH_TIMESTAMP
+                                                        : TCPReceiverMessage::MAX_SACK_BLOCKS;
+  // NOTE: the block holding the latest out-of-order data goes first (RFC 2018)
+  const auto ranges = reassembler_.pending_ranges( latest_out_of_order_index_, max_sack_blocks );
+  for ( const auto& [first, past_last] : ranges ) {
+    msg.sack_blocks.push_back(
+        { Wrap32::wrap( first + 1, isn_.value() ), Wrap32::wrap( past_last + 1, isn_.value() ) } );
+  }
+  return msg;
 }
@@ -9,8 +9,10 @@
 class TCPReceiver
 {
 public:
-  // Construct with given Reassembler
-  explicit TCPReceiver( Reassembler&& reassembler ) : reassembler_( std::move( reassembler ) ) {}
+  // Construct with given Reassembler, and the window scale shift (if any) this end offers in its SYN
+  explicit TCPReceiver( Reassembler&& reassembler, std::optional<uint8_t> window_scale = {} )
+    : reassembler_( std::move( reassembler ) ), window_scale_( window_scale )
+  {}
 
   /*
    * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
@@ -21,6 +23,18 @@ public:
   // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender.
   TCPReceiverMessage send() const;
 
+  // The ackno send() would carry, without building the rest of the message (such as its SACK blocks)
+  std::optional<Wrap32> ackno() const;
+
+  // The window scale shift offered to the peer (the windows in send() are only scaled if the peer offered one too)
+  std::optional<uint8_t> window_scale() const { return window_scale_; }
+
+  // How many segments has PAWS (RFC 7323) rejected as old duplicates, going by their timestamps?
+  uint64_t paws_rejected() const { return paws_rejected_; }
+
+  // Release buffer memory that the currently stored bytes don't need
+  void shrink_to_fit() { reassembler_.shrink_to_fit(); }
+
   // Access the output (only Reader is accessible non-const)
   const Reassembler& reassembler() const { return reassembler_; }
   Reader& reader() { return reassembler_.reader(); }
@@ -30,4 +44,10 @@ public:
 private:
   Reassembler reassembler_;
   std::optional<Wrap32> isn_ = std::nullopt;
+  std::optional<uint8_t> window_scale_;
+  bool peer_window_scale_ = false;         // did the sender's SYN offer window scaling?
+  bool sack_permitted_ = false;            // did the sender's SYN permit SACK blocks?
+  uint64_t latest_out_of_order_index_ = 0; // stream index of the latest payload that arrived out of order
+  std::optional<uint32_t> ts_recent_ {};   // timestamp to echo (RFC 7323's TS.Recent), if the sender sends them
+  uint64_t paws_rejected_ = 0;
 };
@@ -3,8 +3,12 @@
 #include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
 
 using namespace std;
 
@@ -16,6 +20,29 @@ uint64_t nneg_else( uint64_t a, uint64_t b, uint64_t val = 0UL ) {
    return val;
 }
 
+TCPSender::TCPSender( ByteStream&& input,
+                      Wrap32 isn,
+                      uint64_t initial_RTO_ms,
+                      CongestionControl congestion_control,
+                      optional<RTOLimits> RTO_limits )
+  : input_( std::move( input ) )
+  , isn_( isn )
+  , initial_RTO_ms_( initial_RTO_ms )
+  , RTO_limits_( RTO_limits )
+  , current_RTO_ms_( initial_RTO_ms )
+  , persist_timeout_ms_( initial_RTO_ms )
+  , congestion_control_( congestion_control )
+  , congestion_( CongestionController::make( congestion_control, TCPConfig::MAX_PAYLOAD_SIZE ) )
+  , outstanding_()
+{}
+
+void TCPSender::set_mss( size_t mss, bool super_segments )
+{
+  mss_ = mss;
+  max_payload_size_ = super_segments ? max( mss, TCPConfig::MAX_SUPER_SEGMENT ) : mss;
+  congestion_ = CongestionController::make( congestion_control_, mss );
+}
+
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
   return sequence_numbers_in_flight_;
@@ -26,89 +53,317 @@ uint64_t TCPSender::consecutive_retransmissions() const
   return consecutive_retransmition_;
 }
 
+uint64_t TCPSender::congestion_window() const
+{
+  return congestion_ ? congestion_->window() : UINT64_MAX;
+}
+
+optional<uint64_t> TCPSender::smoothed_rtt_ms() const
+{
+  return srtt_us_.has_value() ? optional { *srtt_us_ / 1000 } : nullopt;
+}
+
+optional<uint64_t> TCPSender::rtt_variation_ms() const
+{
+  return srtt_us_.has_value() ? optional { rttvar_us_ / 1000 } : nullopt;
+}
+
+uint64_t TCPSender::current_RTO_ms() const
+{
+  return current_RTO_ms_;
+}
+
+void TCPSender::update_rtt( uint64_t rtt_ms )
+{
+  const uint64_t rtt_us = rtt_ms * 1000;
+  if ( not srtt_us_.has_value() ) {
+    srtt_us_ = rtt_us;
+    rttvar_us_ = rtt_us / 2;
+    return;
+  }
+
+  // RTTVAR <- 3/4 RTTVAR + 1/4 |SRTT - R'|, then SRTT <- 7/8 SRTT + 1/8 R'
+  const uint64_t deviation = *srtt_us_ > rtt_us ? *srtt_us_ - rtt_us : rtt_us - *srtt_us_;
+  rttvar_us_ = ( 3 * rttvar_us_ + deviation ) / 4;
+  srtt_us_ = ( 7 * *srtt_us_ + rtt_us ) / 8;
+}
+
+uint64_t TCPSender::base_RTO_ms() const
+{
+  if ( not RTO_limits_.has_value() or not srtt_us_.has_value() )
+    return initial_RTO_ms_;
+
+  // RTO <- SRTT + max( G, 4 * RTTVAR ), with the clock granularity G being a millisecond
+  const uint64_t rto_ms = ( *srtt_us_ + max<uint64_t>( 1000, 4 * rttvar_us_ ) + 999 ) / 1000;
+  return clamp( rto_ms, RTO_limits_->min_ms, RTO_limits_->max_ms );
+}
+
 void TCPSender::push( const TransmitFunction& transmit )
 {
+  push_batch( [&]( span<const TCPSenderMessage> batch ) {
+    for ( const auto& msg : batch )
+      transmit( msg );
+  } );
+}
+
+void TCPSender::push_batch( const TransmitBatchFunction& transmit )
+{
+  batch_.clear();
+
+  // NOTE: a fast retransmission (asked for by receive()) goes first, ahead of any pacing or window limits.
+  // It resends the first hole not yet resent in this recovery: the earliest outstanding segment, or one the
+  // receiver has (according to SACK) got data beyond
+  if ( retransmit_pending_ ) {
+    retransmit_pending_ = false;
+    for ( auto& segment : outstanding_ ) {
+      if ( segment.sacked || segment.seqno < high_retransmitted_ )
+        continue;
+      if ( &segment != &outstanding_.front() && segment.seqno >= highest_sacked_ )
+        break;
+      segment.msg.timestamp = timestamp();
+      batch_.push_back( segment.msg );
+      segment.retransmitted = true;
+      high_retransmitted_ = segment.seqno + segment.msg.sequence_length();
+      reset_timer();
+      break;
+    }
+  }
+  const size_t retransmissions = batch_.size();
+  const uint64_t first_new_seqno = next_seqno_;
+
   // NOTE: ensure fin can only be pushed once
-  // TODO: any better way?
-  if ( fin_sent_ )
-    return;
+  // NOTE: the loop only plans each message's payload size; the payloads are read afterwards, all at once
+  const optional<uint64_t> pacing_rate = congestion_ ? congestion_->pacing_rate() : nullopt;
+  uint64_t unread = reader().bytes_buffered();
+  payload_sizes_.clear();
+  while ( !fin_sent_ ) {
+    auto msg = make_empty_message();
+    // NOTE: a zero window is probed with one sequence number, whatever the congestion window
+    size_t mod_window_size = window_size_ == 0 ? 1 : min<uint64_t>( window_size_, congestion_window() );
+
+    // NOTE: non-zero window size does NOT MEAN NON-FULL window
+    // NOTE: mod_window_size - in_flight - SYN might be underflow, since window size may change after a message
+    // was sent
+    auto payload_size_limit = std::min(
+      max_payload_size_,
+      static_cast<size_t>( nneg_else( mod_window_size, sequence_numbers_in_flight() + msg.SYN ) ) );
+    const uint64_t payload_size = min<uint64_t>( payload_size_limit, unread );
+
+    // NOTE: Nagle's algorithm and corking hold back the short segment at the end of the buffered data (but not
+    // one cut short by the window, or one that can carry SYN or FIN)
+    const bool short_tail = payload_size > 0 && payload_size == unread && payload_size < mss_;
+    if ( short_tail && !msg.SYN && !input_.writer().is_closed()
+         && ( corked_ || ( nagle_ && sequence_numbers_in_flight_ > 0 ) ) )
+      break;
+
+    // NOTE: when pacing, wait (for tick() to earn more credit) until the whole segment can go
+    if ( pacing_rate.has_value() && max<uint64_t>( payload_size + msg.SYN, 1 ) * 1000 > pacing_credit_ )
+      break;
 
-  auto msg = make_empty_message();
-  size_t mod_window_size = window_size_ == 0 ? 1 : window_size_;
+    unread -= payload_size;
+    msg.FIN = input_.writer().is_closed() && unread == 0;
 
-  // NOTE: non-zero window size does NOT MEAN NON-FULL window
-  // NOTE: mod_window_size - in_flight - SYN might be underflow, since window size may change after a message was sent
-  auto payload_size_limit = std::min( TCPConfig::MAX_PAYLOAD_SIZE, static_cast<size_t>( nneg_else( mod_window_size, sequence_numbers_in_flight() + msg.SYN ) ) );
-  msg.payload = reader().peek().substr( 0, payload_size_limit );
-  input_.reader().pop( msg.payload.size() );
+    // NOTE: when there's no window space for FIN, save it for the next message, instead of trimming payload
+    // payload size is limited by mod_window_size - seqno_in_flight - SYN, so if seq len exceeded available space
+    // again, it's got to be FIN, which is only 1 byte
+    uint64_t length = msg.SYN + payload_size + msg.FIN;
+    if ( length > nneg_else( mod_window_size, sequence_numbers_in_flight() ) ) {
+      msg.FIN = false;
+      length -= 1;
+    }
+
+    // don't send empty message
+    if ( length == 0 )
+      break;
 
-  msg.FIN = reader().is_finished();
+    // maintenance after sending a message
+    fin_sent_ |= msg.FIN;
+    zero_window_probes_ += window_size_ == 0;
+    if ( pacing_rate.has_value() )
+      pacing_credit_ -= min( pacing_credit_, length * 1000 );
+    // NOTE: nothing was in flight, so delivery (for rate estimation) restarts now
+    if ( sequence_numbers_in_flight_ == 0 )
+      delivered_ms_ = now_ms_;
+    sequence_numbers_in_flight_ += length;
+    // when fin_sent_ is true, next_seqno_ is past the FIN
+    next_seqno_ += length;
+    batch_.push_back( move( msg ) );
+    payload_sizes_.push_back( payload_size );
 
-  // NOTE: when there's no window space for FIN, save it for the next message, instead of trimming payload
-  // payload size is limited by mod_window_size - seqno_in_flight - SYN, so if seq len exceeded available space again,
-  // it's got to be FIN, which is only 1 byte
-  if ( msg.sequence_length() > nneg_else( mod_window_size, sequence_numbers_in_flight() ) )
-    msg.FIN = false;
+    // NOTE: keep going while there's input to drain
+    if ( unread == 0 )
+      break;
+  }
 
-  // don't send empty message
-  if ( msg.sequence_length() == 0 )
+  if ( batch_.empty() )
     return;
-  transmit( msg );
 
-  // maintenance after sending a message
-  fin_sent_ |= msg.FIN;
-  outstanding_.push_back( msg );
-  sequence_numbers_in_flight_ += msg.sequence_length();
-  // when fin_sent_ is true, current_sn_ is past_fin_sn_
-  current_sn_ = current_sn_ + msg.sequence_length();
+  // NOTE: the buffered bytes may not be contiguous, so gather them with read() rather than a single peek().
+  // This is the only copy: each new message's payload is a slice of this buffer, which the outstanding queue
+  // (and any retransmission) shares, and which is freed once all of it is acknowledged
+  string burst;
+  read( input_.reader(), reader().bytes_buffered() - unread, burst );
+  const Buffer shared_burst { move( burst ) };
+  size_t offset = 0;
+  for ( size_t i = 0; i < payload_sizes_.size(); ++i ) {
+    batch_[retransmissions + i].payload = shared_burst.substr( offset, payload_sizes_[i] );
+    offset += payload_sizes_[i];
+  }
 
-  // NOTE: resetting and starting timer is differenent, since resetting timer here will wipe former counter
-  start_timer();
+  transmit( batch_ );
 
-  // NOTE: try to drain the input
-  if ( reader().bytes_buffered() )
-    push( transmit );
+  // the new messages are outstanding once sent
+  uint64_t seqno = first_new_seqno;
+  for ( auto& msg : span( batch_ ).subspan( retransmissions ) ) {
+    const uint64_t length = msg.sequence_length();
+    outstanding_.push_back( { seqno, move( msg ), now_ms_, delivered_, delivered_ms_, false, false } );
+    seqno += length;
+  }
+
+  // NOTE: resetting and starting timer is differenent, since resetting timer here will wipe former counter
+  if ( batch_.size() > retransmissions )
+    start_timer();
 }
 
 TCPSenderMessage TCPSender::make_empty_message() const
 {
   auto msg = TCPSenderMessage();
-  msg.seqno = current_sn_;
+  msg.seqno = Wrap32::wrap( next_seqno_, isn_ );
   // NOTE: RST and SYN will not be changed later / FIN will possibly be changed
   // stream_index == 0 equals to: this message has SYN flag
-  msg.SYN = current_sn_ == isn_;
+  msg.SYN = next_seqno_ == 0;
+  msg.SACK_permitted = msg.SYN;
   msg.RST = input_.has_error();
+  msg.timestamp = timestamp();
   return msg;
 }
 
+optional<uint32_t> TCPSender::timestamp() const
+{
+  if ( !timestamps_ )
+    return nullopt;
+  return static_cast<uint32_t>( now_ms_ );
+}
+
 void TCPSender::receive( const TCPReceiverMessage& msg )
 {
   // basics: update window size, set error, ack messages
+  const uint32_t previous_window_size = window_size_;
   window_size_ = msg.window_size;
 
+  // NOTE: a window closing (or opening) swaps the retransmission timer for the persist timer (or back); the
+  // persist schedule starts over from the RTO either way, and an open window lets push() resume right away
+  if ( ( previous_window_size == 0 ) != ( window_size_ == 0 ) ) {
+    persist_timeout_ms_ = current_RTO_ms_;
+    if ( !outstanding_.empty() )
+      reset_timer();
+  }
+
   if ( msg.RST )
     input_.set_error();
 
-  if ( fin_sent_ && msg.ackno == current_sn_ )
+  if ( not msg.ackno.has_value() )
+    return;
+
+  // NOTE: cannot ack a seqno that haven't been sent yet
+  const uint64_t ackno = msg.ackno->unwrap( isn_, next_seqno_ );
+  if ( ackno > next_seqno_ )
+    return;
+
+  if ( fin_sent_ && ackno == next_seqno_ )
     fin_acked_ = true;
 
-  for ( auto it = outstanding_.begin(); it != outstanding_.end(); ) {
-    // TODO: is this unwrap necessary?
-    auto unwrapped_it_seqno = it->seqno.unwrap( isn_, reader().bytes_popped() );
-    auto unwrapped_ackno = msg.ackno->unwrap( isn_, reader().bytes_popped() );
-    auto unwrapped_curr_seqno = current_sn_.unwrap( isn_, reader().bytes_popped() );
-    // NOTE: cannot ack a seqno that haven't been sent yet
-    if ( unwrapped_it_seqno + it->sequence_length() <= unwrapped_ackno && unwrapped_ackno <= unwrapped_curr_seqno ) {
-      // acked new message
-      sequence_numbers_in_flight_ -= it->sequence_length();
-      it = outstanding_.erase( it );
-
-      current_RTO_ms_ = initial_RTO_ms_;
-      reset_timer();
-      consecutive_retransmition_ = 0;
-    } else {
-      ++it;
+  mark_sacked( msg.sack_blocks );
+
+  // segments are in seqno order, so only the front ones can have been acked by this message
+  const uint64_t first_unacked = outstanding_.empty() ? next_seqno_ : outstanding_.front().seqno;
+  const uint64_t in_flight_before = sequence_numbers_in_flight_;
+  RateSample sample;
+  uint64_t latest_delivered_ms = 0;
+  bool covers_retransmission = false;
+  while ( not outstanding_.empty()
+          && outstanding_.front().seqno + outstanding_.front().msg.sequence_length() <= ackno ) {
+    const auto& acked = outstanding_.front();
+    sequence_numbers_in_flight_ -= acked.msg.sequence_length();
+    sample.prior_delivered = acked.delivered;
+    latest_delivered_ms = acked.delivered_ms;
+    sample.rtt_ms = acked.retransmitted ? nullopt : optional { now_ms_ - acked.sent_ms };
+    covers_retransmission |= acked.retransmitted;
+    outstanding_.pop_front();
+  }
+
+  if ( sequence_numbers_in_flight_ < in_flight_before ) {
+    delivered_ += in_flight_before - sequence_numbers_in_flight_;
+    delivered_ms_ = now_ms_;
+    // NOTE: Karn's rule: an ack covering a retransmission may have been triggered by it (and the later segments
+    // held by the receiver until then), so it's no measure of the round trip. A timestamp echo is, since it
+    // says which transmission the ack answers
+    const bool echoed = timestamps_ && msg.timestamp_echo.has_value();
+    if ( echoed )
+      sample.rtt_ms = static_cast<uint32_t>( *timestamp() - *msg.timestamp_echo );
+    if ( sample.rtt_ms.has_value() && ( echoed || !covers_retransmission ) )
+      update_rtt( *sample.rtt_ms );
+    if ( congestion_ ) {
+      congestion_->on_ack( ackno, in_flight_before - sequence_numbers_in_flight_, now_ms_ );
+
+      // the rate at which the segments sent since the latest acked one was sent have been delivered
+      sample.delivered = delivered_;
+      sample.interval_ms = now_ms_ - latest_delivered_ms;
+      sample.in_flight = sequence_numbers_in_flight_;
+      congestion_->on_rate_sample( sample, now_ms_ );
     }
+
+    current_RTO_ms_ = base_RTO_ms();
+    persist_timeout_ms_ = current_RTO_ms_;
+    consecutive_retransmition_ = 0;
+    if ( outstanding_.empty() )
+      stop_timer();
+    else
+      reset_timer();
+
+    // NOTE: in recovery, an ack short of everything outstanding at the loss means the next segment was lost too
+    duplicate_acks_ = 0;
+    if ( recover_.has_value() && ackno >= *recover_ )
+      recover_.reset();
+    else if ( recover_.has_value() )
+      retransmit_pending_ = true;
+    return;
+  }
+
+  // a duplicate ack acknowledges nothing new and leaves the window alone, while something is outstanding
+  // NOTE: fast retransmit is part of congestion control (RFC 5681); without it, repeated acks are just ignored
+  if ( !congestion_ || ackno != first_unacked || outstanding_.empty() || window_size_ != previous_window_size )
+    return;
+
+  duplicate_acks_ += 1;
+  congestion_->on_duplicate_ack( now_ms_ );
+  if ( duplicate_acks_ == TCPConfig::DUPLICATE_ACKS && !recover_.has_value() ) {
+    recover_ = next_seqno_;
+    retransmit_pending_ = true;
+    high_retransmitted_ = 0;
+    congestion_->on_loss( LossSignal::FastRetransmit, next_seqno_, sequence_numbers_in_flight_, now_ms_ );
+  } else if ( recover_.has_value() ) {
+    // NOTE: with SACK, each duplicate ack in recovery can fill another hole
+    retransmit_pending_ = true;
+  }
+}
+
+void TCPSender::mark_sacked( const vector<SACKBlock>& blocks )
+{
+  for ( const auto& block : blocks ) {
+    const uint64_t left = block.left.unwrap( isn_, next_seqno_ );
+    const uint64_t right = block.right.unwrap( isn_, next_seqno_ );
+    // NOTE: ignore blocks for sequence numbers never sent
+    if ( left >= right || right > next_seqno_ )
+      continue;
+
+    const auto starts_before = []( const OutstandingSegment& segment, uint64_t seqno ) {
+      return segment.seqno < seqno;
+    };
+    auto it = lower_bound( outstanding_.begin(), outstanding_.end(), left, starts_before );
+    for ( ; it != outstanding_.end() && it->seqno + it->msg.sequence_length() <= right; ++it )
+      it->sacked = true;
+    highest_sacked_ = max( highest_sacked_, right );
   }
 }
 
@@ -119,37 +374,69 @@ void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& trans
     return;
 
   // do tick
-  if ( timer_enabled_ )
-    timer_count_ += ms_since_last_tick;
+  now_ms_ += ms_since_last_tick;
+  bool timer_expired = false;
+  bool persist_timer_expired = false;
+  timers_.advance( ms_since_last_tick, [&]( uint64_t timer ) {
+    ( timer == PERSIST_TIMER ? persist_timer_expired : timer_expired ) = true;
+  } );
 
-  if ( is_timer_expired() ) {
+  // probe the zero window again, backing off (when the RTO adapts) up to the maximum RTO
+  if ( persist_timer_expired ) {
+    outstanding_.front().msg.timestamp = timestamp();
+    transmit( outstanding_.front().msg );
+    outstanding_.front().retransmitted = true;
+    zero_window_probes_ += 1;
+    if ( RTO_limits_.has_value() )
+      persist_timeout_ms_ = min( 2 * persist_timeout_ms_, max( RTO_limits_->max_ms, initial_RTO_ms_ ) );
+    reset_timer();
+  }
+
+  if ( timer_expired ) {
     // retransmit earliest outstanding message
-    transmit( outstanding_.front() );
+    outstanding_.front().msg.timestamp = timestamp();
+    transmit( outstanding_.front().msg );
+    outstanding_.front().retransmitted = true;
 
-    if ( window_size_ != 0 ) {
-      consecutive_retransmition_ += 1;
-      // exponential backoff
-      current_RTO_ms_ *= 2;
-    }
+    // NOTE: after a timeout, recovery starts over
+    duplicate_acks_ = 0;
+    recover_.reset();
+
+    if ( congestion_ )
+      congestion_->on_loss( LossSignal::Timeout, next_seqno_, sequence_numbers_in_flight_, now_ms_ );
+    consecutive_retransmition_ += 1;
+    // exponential backoff
+    current_RTO_ms_ *= 2;
+    if ( RTO_limits_.has_value() )
+      current_RTO_ms_ = min( current_RTO_ms_, max( RTO_limits_->max_ms, initial_RTO_ms_ ) );
 
     reset_timer();
   }
+
+  // earn pacing credit, keeping no more than a small burst (or one tick's worth) of it, and spend it
+  const optional<uint64_t> pacing_rate = congestion_ ? congestion_->pacing_rate() : nullopt;
+  if ( pacing_rate.has_value() ) {
+    const uint64_t earned = *pacing_rate * ms_since_last_tick;
+    pacing_credit_ = min( pacing_credit_ + earned, max( earned, 2 * max_payload_size_ * 1000 ) );
+    push( transmit );
+  }
 }
 
+// NOTE: "the timer" is the persist timer while the window is zero, and the retransmission timer otherwise
 void TCPSender::reset_timer() {
-  timer_enabled_ = true;
-  timer_count_ = 0;
+  stop_timer();
+  if ( window_size_ == 0 )
+    persist_timer_ = timers_.arm( persist_timeout_ms_, PERSIST_TIMER );
+  else
+    retransmission_timer_ = timers_.arm( current_RTO_ms_, RETRANSMISSION_TIMER );
 }
 
 void TCPSender::start_timer() {
-  timer_enabled_ = true;
+  if ( !timers_.armed( retransmission_timer_ ) && !timers_.armed( persist_timer_ ) )
+    reset_timer();
 }
 
 void TCPSender::stop_timer() {
-  timer_enabled_ = false;
-  timer_count_ = 0;
+  timers_.cancel( retransmission_timer_ );
+  timers_.cancel( persist_timer_ );
 }
-
-bool TCPSender::is_timer_expired() const {
-  return timer_count_ >= current_RTO_ms_;
-}
\ No newline at end of file
@@ -1,26 +1,64 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_controller.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
+#include "timer_wheel.hh"
 #include "wrapping_integers.hh"
 
 #include <cstdint>
 #include <functional>
 #include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Bounds on an adaptive retransmission timeout
+struct RTOLimits
+{
+  uint64_t min_ms;
+  uint64_t max_ms;
+};
 
 class TCPSender
 {
 public:
-  /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-  TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
-    : input_( std::move( input ) )
-    , isn_( isn )
-    , initial_RTO_ms_( initial_RTO_ms )
-    , current_sn_( isn )
-    , current_RTO_ms_( initial_RTO_ms )
-    , outstanding_()
-  {}
+  /*
+   * Construct TCP sender with given default Retransmission Timeout, possible ISN and congestion control.
+   * With `RTO_limits`, the RTO follows the measured RTT (RFC 6298) within those limits; without, it stays
+   * at the initial RTO (apart from exponential backoff).
+   */
+  TCPSender( ByteStream&& input,
+             Wrap32 isn,
+             uint64_t initial_RTO_ms,
+             CongestionControl congestion_control = CongestionControl::None,
+             std::optional<RTOLimits> RTO_limits = {} );
+
+  /*
+   * Limit segments to `mss` payload bytes (TCPConfig::MAX_PAYLOAD_SIZE until this is called). With
+   * `super_segments`, messages may carry up to TCPConfig::MAX_SUPER_SEGMENT bytes instead, for the IP layer to
+   * split into MSS-sized segments. Call before sending any data: it restarts congestion control.
+   */
+  void set_mss( size_t mss, bool super_segments = false );
+
+  /*
+   * Coalesce small writes. With Nagle's algorithm (RFC 896), a segment shorter than the MSS waits until nothing
+   * is in flight. While corked, it waits until uncork() instead, however much is in flight. Either way, a
+   * full segment (or the end of the stream) goes right away. Both are off until enabled.
+   */
+  void set_nagle( bool enabled ) { nagle_ = enabled; }
+  void cork() { corked_ = true; }
+  void uncork() { corked_ = false; } // (push afterwards to send what was held back)
+  bool corked() const { return corked_; }
+
+  /*
+   * Stamp every message with the time (the RFC 7323 timestamp option, off until enabled), and measure the RTT
+   * from the echoes acknowledgments carry back, on every acknowledgment of new data, retransmissions included.
+   */
+  void set_timestamps( bool enabled ) { timestamps_ = enabled; }
 
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage make_empty_message() const;
@@ -31,15 +69,29 @@ public:
   /* Type of the `transmit` function that the push and tick methods can use to send messages */
   using TransmitFunction = std::function<void( const TCPSenderMessage& )>;
 
+  /* Type of the `transmit` function that push_batch uses to send a burst of messages at once */
+  using TransmitBatchFunction = std::function<void( std::span<const TCPSenderMessage> )>;
+
   /* Push bytes from the outbound stream */
   void push( const TransmitFunction& transmit );
 
+  /* Push bytes from the outbound stream, handing everything this sends to `transmit` in a single call */
+  void push_batch( const TransmitBatchFunction& transmit );
+
   /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
   void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit );
 
   // Accessors
   uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t congestion_window() const;           // How many sequence numbers may congestion control have in flight?
+  std::optional<uint64_t> smoothed_rtt_ms() const;  // SRTT, once there's an RTT sample
+  std::optional<uint64_t> rtt_variation_ms() const; // RTTVAR, once there's an RTT sample
+  uint64_t current_RTO_ms() const;                  // The retransmission timeout (including any backoff)
+  uint64_t zero_window_probes() const { return zero_window_probes_; } // How many probes has a zero window drawn?
+  uint64_t persist_timeout_ms() const { return persist_timeout_ms_; } // Wait before the next zero-window probe
+  size_t mss() const { return mss_; }               // The maximum segment size (super-segments may be larger)
+  size_t max_payload_size() const { return max_payload_size_; }
   Writer& writer() { return input_.writer(); }
   const Writer& writer() const { return input_.writer(); }
 
@@ -52,23 +104,81 @@ private:
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
 
-  Wrap32 current_sn_;
+  uint64_t next_seqno_ { 0 }; // absolute seqno of the next sequence number to send
   bool fin_sent_ { false };
   bool fin_acked_ { false };
 
-  uint16_t window_size_ { 1 };
+  uint32_t window_size_ { 1 };
   uint64_t sequence_numbers_in_flight_ { 0 };
 
+  std::optional<RTOLimits> RTO_limits_;
   uint64_t current_RTO_ms_;
-  uint64_t timer_count_ { 0 };
-  bool timer_enabled_ { false };
+  // RTT estimates (in microseconds, to keep the fractions of RFC 6298's gains)
+  std::optional<uint64_t> srtt_us_ {};
+  uint64_t rttvar_us_ { 0 };
+  // NOTE: while the receiver's window is zero, the persist timer takes the retransmission timer's place: it
+  // resends the probe on its own schedule, without counting retransmissions or signalling loss
+  static constexpr uint64_t RETRANSMISSION_TIMER = 0;
+  static constexpr uint64_t PERSIST_TIMER = 1;
+  TimerWheel timers_ {};
+  TimerWheel::Handle retransmission_timer_ {};
+  TimerWheel::Handle persist_timer_ {};
+  uint64_t persist_timeout_ms_;
+  uint64_t zero_window_probes_ { 0 };
 
   uint64_t consecutive_retransmition_ { 0 };
 
-  std::deque<TCPSenderMessage> outstanding_;
+  // fast retransmit and (NewReno-style) fast recovery
+  uint64_t duplicate_acks_ { 0 };
+  std::optional<uint64_t> recover_ {}; // in recovery, the next_seqno_ when the loss was detected
+  bool retransmit_pending_ { false };  // resend the next hole on the next push
+  uint64_t high_retransmitted_ { 0 };  // holes below this were already resent in this recovery
+  uint64_t highest_sacked_ { 0 };      // end of the highest block the receiver has reported holding
+
+  uint64_t now_ms_ { 0 };                               // total time passed to tick()
+  CongestionControl congestion_control_;
+  std::unique_ptr<CongestionController> congestion_ {}; // null without congestion control
+
+  size_t mss_ { TCPConfig::MAX_PAYLOAD_SIZE };
+  size_t max_payload_size_ { TCPConfig::MAX_PAYLOAD_SIZE }; // per message (larger than mss_ with super-segments)
+  bool nagle_ { false };
+  bool corked_ { false };
+  bool timestamps_ { false };
+
+  // delivery rate estimation
+  uint64_t delivered_ { 0 };    // sequence numbers acknowledged so far
+  uint64_t delivered_ms_ { 0 }; // when delivered_ last grew (or the first send after an idle period)
+
+  // pacing, when congestion control asks for it: transmission credit (in thousandths of a byte) earned in tick()
+  uint64_t pacing_credit_ { 0 };
+
+  // a sent segment, with the absolute seqno of its first sequence number and the delivery state when it was sent
+  struct OutstandingSegment
+  {
+    uint64_t seqno;
+    TCPSenderMessage msg;
+    uint64_t sent_ms;
+    uint64_t delivered;
+    uint64_t delivered_ms;
+    bool retransmitted;
+    bool sacked; // the receiver holds it (beyond the ackno), so it needn't be resent
+  };
+  std::deque<OutstandingSegment> outstanding_; // in seqno order, so acks only ever pop from the front
+
+  std::vector<TCPSenderMessage> batch_ {}; // messages being sent by push_batch (kept to reuse its capacity)
+  std::vector<size_t> payload_sizes_ {};   // ... and the payload sizes planned for the new ones
+
+  // record the segments the receiver reports holding in SACK blocks
+  void mark_sacked( const std::vector<SACKBlock>& blocks );
+
+  // take an RTT sample (from a segment that wasn't retransmitted, or from a timestamp echo) into the estimates
+  void update_rtt( uint64_t rtt_ms );
+  // the timestamp option for a message sent now
+  std::optional<uint32_t> timestamp() const;
+  // the RTO from the estimates (or the initial RTO), before any backoff
+  uint64_t base_RTO_ms() const;
 
   void reset_timer();
   void start_timer();
   void stop_timer();
-  bool is_timer_expired() const;
 };
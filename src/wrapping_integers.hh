@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
 /*
  * The Wrap32 type represents a 32-bit unsigned integer that:
@@ -11,10 +12,13 @@
 class Wrap32
 {
 public:
-  explicit Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
+  explicit constexpr Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
 
   /* Construct a Wrap32 given an absolute sequence number n and the zero point. */
-  static Wrap32 wrap( uint64_t n, Wrap32 zero_point );
+  static constexpr Wrap32 wrap( uint64_t n, Wrap32 zero_point )
+  {
+    return zero_point + static_cast<uint32_t>( n );
+  }
 
   /*
    * The unwrap method returns an absolute sequence number that wraps to this Wrap32, given the zero point
@@ -23,10 +27,28 @@ public:
    * There are many possible absolute sequence numbers that all wrap to the same Wrap32.
    * The unwrap method should return the one that is closest to the checkpoint.
    */
-  uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const;
+  constexpr uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+  {
+    // signed distance from the checkpoint to the nearest candidate (ties go to the smaller candidate)
+    const int64_t distance
+      = static_cast<int32_t>( raw_value_ - zero_point.raw_value_ - static_cast<uint32_t>( checkpoint ) );
+    const uint64_t candidate = checkpoint + static_cast<uint64_t>( distance );
+    // N.B. a candidate below zero doesn't exist, so take the next one up instead
+    const bool below_zero = distance < 0 and checkpoint < static_cast<uint64_t>( -distance );
+    return candidate + ( static_cast<uint64_t>( below_zero ) << 32 );
+  }
 
-  Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
-  bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
+  /*
+   * Unwrap each of `values` into the corresponding element of `out`, as with `unwrap`.
+   * Only the first min( values.size(), out.size() ) elements are unwrapped.
+   */
+  static void unwrap_batch( std::span<const Wrap32> values,
+                            Wrap32 zero_point,
+                            uint64_t checkpoint,
+                            std::span<uint64_t> out );
+
+  constexpr Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
+  constexpr bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
 
 protected:
   uint32_t raw_value_ {};
@@ -0,0 +1,142 @@
+#include "spsc_byte_stream.hh"
+
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// Sleep until the eventfd is readable
+static void wait_for( EventFD& event )
+{
+  pollfd pfd { event.fd_num(), POLLIN, 0 };
+  if ( ::poll( &pfd, 1, 1000 ) != 1 ) {
+    throw runtime_error( "timed out waiting for SPSCByteStream event" );
+  }
+}
+
+static void expect_notifications( EventFD& event, uint64_t expected, const string& what )
+{
+  const uint64_t count = event.clear();
+  if ( count != expected ) {
+    throw runtime_error( what + ": expected " + to_string( expected ) + " notification(s), got "
+                         + to_string( count ) );
+  }
+}
+
+// The eventfds should be written once per transition, not once per push or pop
+void transition_test()
+{
+  SPSCByteStream stream { 8 };
+  expect_notifications( stream.space_event(), 1, "new stream" );
+
+  stream.push( "a" );
+  stream.push( "b" );
+  stream.push( "c" );
+  expect_notifications( stream.data_event(), 1, "three pushes to an empty stream" );
+
+  stream.pop( 1 );
+  stream.push( "d" );
+  expect_notifications( stream.data_event(), 0, "push to a non-empty stream" );
+
+  stream.pop( 3 );
+  stream.push( "e" );
+  stream.push( "f" );
+  expect_notifications( stream.data_event(), 1, "pushes after the stream was drained" );
+
+  stream.push( "ghijklmn" );
+  expect_notifications( stream.space_event(), 0, "pops and pushes that never filled the stream" );
+  stream.pop( 1 );
+  stream.pop( 1 );
+  stream.pop( 1 );
+  expect_notifications( stream.space_event(), 1, "three pops from a full stream" );
+
+  if ( stream.prepare_wait_for_data() ) {
+    throw runtime_error( "prepare_wait_for_data() should refuse to sleep with bytes buffered" );
+  }
+  stream.pop( stream.bytes_buffered() );
+  if ( not stream.prepare_wait_for_data() ) {
+    throw runtime_error( "prepare_wait_for_data() should allow sleeping on an empty stream" );
+  }
+  stream.close();
+  expect_notifications( stream.data_event(), 1, "close" );
+}
+
+void threaded_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                    const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                    const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  SPSCByteStream stream { capacity };
+
+  thread producer { [&] {
+    default_random_engine rd { random_seed + 1 };
+    uniform_int_distribution<size_t> write_size { 1, capacity * 2 };
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      const size_t n = stream.push( string_view { data }.substr( pushed, write_size( rd ) ) );
+      if ( n == 0 and stream.prepare_wait_for_space() ) {
+        wait_for( stream.space_event() );
+      }
+      pushed += n;
+    }
+    stream.close();
+  } };
+
+  default_random_engine rd { random_seed + 2 };
+  uniform_int_distribution<size_t> read_size { 1, capacity };
+  string output;
+  while ( not stream.is_finished() ) {
+    if ( stream.bytes_buffered() == 0 ) {
+      if ( stream.prepare_wait_for_data() ) {
+        wait_for( stream.data_event() );
+      }
+      continue;
+    }
+    const auto piece = stream.peek_both().first.substr( 0, read_size( rd ) );
+    if ( piece.empty() ) {
+      throw runtime_error( "SPSCByteStream::peek_both() returned empty view with bytes buffered" );
+    }
+    output += piece;
+    stream.pop( piece.size() );
+  }
+
+  producer.join();
+
+  if ( output != data ) {
+    throw runtime_error( "Mismatch between data pushed and popped (input=" + to_string( input_len )
+                         + ", capacity=" + to_string( capacity ) + ")" );
+  }
+  if ( stream.bytes_pushed() != input_len or stream.bytes_popped() != input_len ) {
+    throw runtime_error( "SPSCByteStream byte counts are wrong" );
+  }
+}
+
+int main()
+{
+  try {
+    transition_test();
+    threaded_test( 19, 3, 10110 );
+    threaded_test( 1111, 17, 98765 );
+    threaded_test( 100000, 4096, 11101 );
+    threaded_test( 1000000, 65536, 12345 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -16,8 +16,13 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Ring )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ( storage == ByteStream::Storage::Chunked ? ", chunked" : "" ),
+                   ByteStream { capacity, storage } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
@@ -107,6 +112,31 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekIov : public Peek
+{
+  using Peek::Peek;
+
+  std::string description() const override
+  {
+    return "peek_iov( " + std::to_string( output_.size() ) + " ) gives \"" + Printer::prettify( output_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    std::string got;
+    for ( const auto piece : bs.reader().peek_iov( output_.size() ) ) {
+      if ( piece.empty() ) {
+        throw ExpectationViolation { "Reader::peek_iov() returned an empty piece" };
+      }
+      got += piece;
+    }
+    if ( got != output_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\" from peek_iov(), "
+                                   + "but found \"" + Printer::prettify( got ) + "\"" };
+    }
+  }
+};
+
 struct IsClosed : public ConstExpectBool<ByteStream>
 {
   using ConstExpectBool::ConstExpectBool;
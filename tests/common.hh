@@ -35,6 +35,15 @@ inline ExpectationViolation::ExpectationViolation( const std::string& property_n
                            + ", but instead it was " + boolstr( actual ) + "." }
 {}
 
+// For checks that don't step through a TestHarness (e.g. of stateless parsing): unless `condition` holds,
+// throw an ExpectationViolation saying what was expected
+inline void expect( bool condition, const std::string& expectation )
+{
+  if ( not condition ) {
+    throw ExpectationViolation { "Expected " + expectation + ", but it was not so." };
+  }
+}
+
 template<class T>
 struct TestStep
 {
@@ -0,0 +1,179 @@
+#include "fd_adapter.hh"
+#include "lossy_fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+// One direction of a simulated path: a drop-tail queue drained at a fixed rate into a fixed propagation delay
+class SimulatedPath
+{
+  size_t segments_per_ms_;
+  uint64_t delay_ms_;
+  size_t queue_limit_;
+
+  deque<TCPMessage> queue_ {};
+  deque<pair<uint64_t, TCPMessage>> propagating_ {}; // with the time each message arrives
+
+public:
+  uint64_t drops {};
+
+  SimulatedPath( size_t segments_per_ms, uint64_t delay_ms, size_t queue_limit )
+    : segments_per_ms_( segments_per_ms ), delay_ms_( delay_ms ), queue_limit_( queue_limit )
+  {}
+
+  void send( const TCPMessage& msg )
+  {
+    if ( queue_.size() >= queue_limit_ ) {
+      ++drops;
+      return;
+    }
+    queue_.push_back( msg );
+  }
+
+  void tick( uint64_t now )
+  {
+    for ( size_t i = 0; i < segments_per_ms_ and not queue_.empty(); ++i ) {
+      propagating_.emplace_back( now + delay_ms_, move( queue_.front() ) );
+      queue_.pop_front();
+    }
+  }
+
+  optional<TCPMessage> receive( uint64_t now )
+  {
+    if ( propagating_.empty() or propagating_.front().first > now ) {
+      return {};
+    }
+    TCPMessage msg = move( propagating_.front().second );
+    propagating_.pop_front();
+    return msg;
+  }
+};
+
+// A peer's end of the simulated paths, in the shape LossyFdAdapter expects
+class SimulatedAdapter : public FdAdapterBase
+{
+  SimulatedPath& outbound_;
+  SimulatedPath& inbound_;
+  const uint64_t& now_;
+
+public:
+  SimulatedAdapter( SimulatedPath& outbound, SimulatedPath& inbound, const uint64_t& now )
+    : outbound_( outbound ), inbound_( inbound ), now_( now )
+  {}
+
+  optional<TCPMessage> read() { return inbound_.receive( now_ ); }
+  void write( const TCPMessage& msg ) { outbound_.send( msg ); }
+};
+
+void speed_test( const CongestionControl algorithm,
+                 const string& name,
+                 const uint64_t total_bytes, // NOLINT(bugprone-easily-swappable-parameters)
+                 const uint16_t loss_rate )  // NOLINT(bugprone-easily-swappable-parameters)
+{
+  // 8 Mbit/s bottleneck (with 1000-byte payloads), 40 ms round trip, 20-segment queue
+  SimulatedPath forward { 1, 20, 20 };
+  SimulatedPath backward { 1, 20, 20 };
+  uint64_t now = 0;
+
+  LossyFdAdapter<SimulatedAdapter> sender_adapter { SimulatedAdapter { forward, backward, now } };
+  LossyFdAdapter<SimulatedAdapter> receiver_adapter { SimulatedAdapter { backward, forward, now } };
+  sender_adapter.config_mut().loss_rate_up = loss_rate;
+
+  TCPConfig cfg;
+  cfg.rt_timeout = 100;
+  cfg.congestion_control = algorithm;
+  TCPPeer sender { cfg };
+  TCPPeer receiver { cfg };
+
+  uint64_t bytes_sent = 0;
+  const auto transmit_data = [&]( const TCPMessage& msg ) {
+    bytes_sent += msg.sender.payload.size();
+    sender_adapter.write( msg );
+  };
+  const auto transmit_acks = [&]( const TCPMessage& msg ) { receiver_adapter.write( msg ); };
+
+  uint64_t bytes_written = 0;
+  uint64_t bytes_read = 0;
+  const uint64_t give_up_ms = 600000;
+
+  sender.push( transmit_data );
+  while ( bytes_read < total_bytes ) {
+    if ( ++now > give_up_ms ) {
+      throw runtime_error( name + " did not finish the transfer" );
+    }
+
+    // move data along the path and into the peers
+    forward.tick( now );
+    backward.tick( now );
+    while ( auto msg = receiver_adapter.read() ) {
+      receiver.receive( move( *msg ), transmit_acks );
+    }
+    while ( auto msg = sender_adapter.read() ) {
+      sender.receive( move( *msg ), transmit_data );
+    }
+
+    // keep the sender's stream full and the receiver's empty
+    Writer& writer = sender.outbound_writer();
+    const uint64_t to_write = min( writer.available_capacity(), total_bytes - bytes_written );
+    if ( to_write > 0 ) {
+      writer.push( string( to_write, 'x' ) );
+      bytes_written += to_write;
+      sender.push( transmit_data );
+    }
+    Reader& reader = receiver.inbound_reader();
+    bytes_read += reader.bytes_buffered();
+    reader.pop( reader.bytes_buffered() );
+
+    sender.tick( 1, transmit_data );
+    receiver.tick( 1, transmit_acks );
+  }
+
+  const double seconds = static_cast<double>( now ) / 1000.0;
+  const double megabits_per_second = 8 * static_cast<double>( total_bytes ) / seconds / 1e6;
+  const double overhead = static_cast<double>( bytes_sent ) / static_cast<double>( total_bytes );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << name << " with loss rate " << fixed << setprecision( 2 ) << 100.0 * loss_rate / 65536
+       << "% reached " << megabits_per_second << " Mbit/s (of 8) in simulated time, with " << forward.drops
+       << " segments dropped at the bottleneck and " << overhead << "x the bytes sent.\n";
+
+  debug_output << setw( 10 ) << name << " throughput (" << fixed << setprecision( 2 )
+               << 100.0 * loss_rate / 65536 << "% loss): " << megabits_per_second << " Mbit/s\n";
+}
+
+void program_body()
+{
+  for ( const uint16_t loss_rate : { 0, 66, 655 } ) {
+    speed_test( CongestionControl::None, "None", 2000000, loss_rate );
+    speed_test( CongestionControl::Reno, "Reno", 2000000, loss_rate );
+    speed_test( CongestionControl::NewReno, "NewReno", 2000000, loss_rate );
+    speed_test( CongestionControl::Cubic, "CUBIC", 2000000, loss_rate );
+    speed_test( CongestionControl::BBR, "BBR", 2000000, loss_rate );
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// Feed the same random (overlapping, out-of-order) substrings to a copying and a segment-retaining
+// Reassembler, and check that they always agree.
+void differential_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                        const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                        const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  Reassembler copying { ByteStream { capacity } };
+  Reassembler retaining { ByteStream { capacity, ByteStream::Storage::Chunked } };
+  string copied_output;
+  string retained_output;
+
+  uniform_int_distribution<size_t> length_dist { 0, capacity / 2 + 1 };
+  while ( not retaining.reader().is_finished() ) {
+    const uint64_t base = retaining.writer().bytes_pushed();
+    uniform_int_distribution<size_t> offset_dist { base, base + capacity };
+    const size_t first_index = min( offset_dist( rd ), data.size() );
+    const string piece = data.substr( first_index, length_dist( rd ) );
+    const bool is_last = first_index + piece.size() == data.size();
+
+    copying.insert( first_index, piece, is_last );
+    retaining.insert( first_index, piece, is_last );
+
+    if ( copying.bytes_pending() != retaining.bytes_pending()
+         or copying.writer().bytes_pushed() != retaining.writer().bytes_pushed()
+         or copying.writer().is_closed() != retaining.writer().is_closed() ) {
+      throw runtime_error( "copying and segment-retaining Reassemblers disagree after inserting @ "
+                           + to_string( first_index ) );
+    }
+
+    uniform_int_distribution<size_t> pop_dist { 0, retaining.reader().bytes_buffered() };
+    const size_t pop_len = pop_dist( rd );
+    string popped;
+    read( copying.reader(), pop_len, popped );
+    copied_output += popped;
+    read( retaining.reader(), pop_len, popped );
+    retained_output += popped;
+  }
+
+  if ( copied_output != data or retained_output != data ) {
+    throw runtime_error( "Mismatch between data inserted and read" );
+  }
+}
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "retained: overlap between two pending", 1000, ByteStream::Storage::Chunked };
+
+      test.execute( Insert { "bc", 1 } );
+      test.execute( Insert { "ef", 4 } );
+      test.execute( BytesPending( 4 ) );
+
+      test.execute( Insert { "cde", 2 } );
+      test.execute( ReadAll( "" ) );
+      test.execute( BytesPushed( 0 ) );
+      test.execute( BytesPending( 5 ) );
+
+      test.execute( Insert { "abcdefg", 0 } );
+      test.execute( BytesPushed( 7 ) );
+      test.execute( BytesPending( 0 ) );
+      test.execute( ReadAll( "abcdefg" ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "retained: insert within existing", 1000, ByteStream::Storage::Chunked };
+
+      test.execute( Insert { "bcd", 1 } );
+      test.execute( Insert { "c", 2 } );
+      test.execute( BytesPending( 3 ) );
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( ReadAll( "abcd" ) );
+      test.execute( BytesPending( 0 ) );
+    }
+
+    {
+      ReassemblerTestHarness test { "retained: trimmed to capacity", 4, ByteStream::Storage::Chunked };
+
+      test.execute( Insert { "cdefg", 2 } );
+      test.execute( BytesPending( 2 ) );
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed( 4 ) );
+      test.execute( ReadAll( "abcd" ) );
+
+      test.execute( Insert { "efgh", 4 }.is_last() );
+      test.execute( ReadAll( "efgh" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "retained: already-pushed prefix", 1000, ByteStream::Storage::Chunked };
+
+      test.execute( Insert { "abc", 0 } );
+      test.execute( ReadAll( "abc" ) );
+
+      test.execute( Insert { "abcdef", 0 }.is_last() );
+      test.execute( ReadAll( "def" ) );
+      test.execute( IsFinished { true } );
+    }
+
+    differential_test( 1000, 7, 10110 );
+    differential_test( 100000, 1500, 98765 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
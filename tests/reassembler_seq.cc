@@ -62,6 +62,29 @@ int main()
       }
     }
 
+    for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+      ReassemblerTestHarness test { "fast path", 8, storage };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( FastPathInserts( 1 ) );
+      test.execute( Insert { "fg", 5 } );
+      test.execute( FastPathInserts( 1 ) );
+      test.execute( Insert { "e", 4 } );
+      test.execute( FastPathInserts( 1 ) );
+      test.execute( BytesPushed( 7 ) );
+      test.execute( BytesPending( 0 ) );
+
+      test.execute( Insert { "hijk", 7 } );
+      test.execute( FastPathInserts( 2 ) );
+      test.execute( BytesPushed( 8 ) );
+      test.execute( ReadAll( "abcdefgh" ) );
+
+      test.execute( Insert { "ijk", 8 }.is_last() );
+      test.execute( FastPathInserts( 3 ) );
+      test.execute( ReadAll( "ijk" ) );
+      test.execute( IsFinished { true } );
+    }
+
     {
       ReassemblerTestHarness test { "zero-valued byte in substring", 16 };
 
@@ -13,9 +13,10 @@
 using namespace std;
 using namespace std::chrono;
 
-void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
-                 const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const ByteStream::Storage storage = ByteStream::Storage::Ring )
 {
   // Generate the data to be written
   const string data = [&] {
@@ -36,7 +37,7 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
     split_data.emplace( i + 1, data.substr( i + 1, capacity * 2 ), i + 1 + capacity * 2 >= data.size() );
   }
 
-  Reassembler reassembler { ByteStream { capacity } };
+  Reassembler reassembler { ByteStream { capacity, storage } };
 
   string output_data;
   output_data.reserve( data.size() );
@@ -71,8 +72,9 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  cout << "Reassembler to ByteStream with capacity=" << capacity
+       << ( storage == ByteStream::Storage::Chunked ? " (retaining segments)" : "" ) << " reached " << fixed
+       << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
   debug_output << "             Reassembler throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
                << " Gbit/s\n";
@@ -82,9 +84,89 @@ void speed_test( const size_t num_chunks,   // NOLINT(bugprone-easily-swappable-
   }
 }
 
+void holes_speed_test( const size_t num_rounds, // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t num_holes,  // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t chunk_size, // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t random_seed )
+{
+  const size_t round_size = 2 * num_holes * chunk_size;
+
+  // Generate the data to be written
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < num_rounds * round_size; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  // Each round first leaves `num_holes` holes (every other chunk), then fills them back to front
+  queue<tuple<uint64_t, string, bool>> split_data;
+  for ( size_t round = 0; round < num_rounds; ++round ) {
+    const size_t base = round * round_size;
+    for ( size_t i = 1; i < 2 * num_holes; i += 2 ) {
+      const size_t index = base + i * chunk_size;
+      split_data.emplace( index, data.substr( index, chunk_size ), index + chunk_size == data.size() );
+    }
+    for ( size_t i = 2 * num_holes; i > 0; i -= 2 ) {
+      const size_t index = base + ( i - 2 ) * chunk_size;
+      split_data.emplace( index, data.substr( index, chunk_size ), false );
+    }
+  }
+
+  Reassembler reassembler { ByteStream { round_size } };
+
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  while ( not split_data.empty() ) {
+    auto& next = split_data.front();
+    reassembler.insert( get<uint64_t>( next ), move( get<string>( next ) ), get<bool>( next ) );
+    split_data.pop();
+
+    while ( reassembler.reader().bytes_buffered() ) {
+      output_data += reassembler.reader().peek();
+      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+    }
+  }
+
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  auto bytes_per_second = static_cast<double>( data.size() ) / test_duration.count();
+  auto bits_per_second = 8 * bytes_per_second;
+  auto gigabits_per_second = bits_per_second / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Reassembler with " << num_holes << " holes of " << chunk_size << " bytes reached " << fixed
+       << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  debug_output << "   Reassembler (with holes) throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
+               << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "Reassembler with holes did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
 void program_body()
 {
   speed_test( 10000, 1500, 1370 );
+  speed_test( 10000, 1500, 1370, ByteStream::Storage::Chunked );
+  holes_speed_test( 10, 10000, 100, 1370 );
 }
 
 int main()
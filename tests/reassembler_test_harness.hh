@@ -27,10 +27,13 @@ struct ReassemblerTestStep : public TestStep<Reassembler>
 class ReassemblerTestHarness : public TestHarness<Reassembler>
 {
 public:
-  ReassemblerTestHarness( std::string test_name, uint64_t capacity )
+  ReassemblerTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          ByteStream::Storage storage = ByteStream::Storage::Ring )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { Reassembler { ByteStream { capacity } } } )
+                   "capacity=" + std::to_string( capacity )
+                     + ( storage == ByteStream::Storage::Chunked ? ", retaining segments" : "" ),
+                   { Reassembler { ByteStream { capacity, storage } } } )
   {}
 
   template<std::derived_from<TestStep<ByteStream>> T>
@@ -49,6 +52,13 @@ struct BytesPending : public ConstExpectNumber<Reassembler, uint64_t>
   uint64_t value( const Reassembler& r ) const override { return r.bytes_pending(); }
 };
 
+struct FastPathInserts : public ConstExpectNumber<Reassembler, uint64_t>
+{
+  using ConstExpectNumber::ConstExpectNumber;
+  std::string name() const override { return "fast_path_inserts"; }
+  uint64_t value( const Reassembler& r ) const override { return r.fast_path_inserts(); }
+};
+
 struct Insert : public Action<Reassembler>
 {
   std::string data_;
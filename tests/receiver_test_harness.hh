@@ -5,9 +5,12 @@
 #include "tcp_receiver.hh"
 #include "tcp_receiver_message.hh"
 
+#include <algorithm>
 #include <optional>
 #include <sstream>
+#include <string>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver>
@@ -40,10 +43,18 @@ struct DirectByteStreamTest : public TestStep<TCPReceiver>
 class TCPReceiverTestHarness : public TestHarness<TCPReceiver>
 {
 public:
-  TCPReceiverTestHarness( std::string test_name, uint64_t capacity )
+  TCPReceiverTestHarness( std::string test_name,
+                          uint64_t capacity,
+                          ByteStream::Storage storage = ByteStream::Storage::Ring )
     : TestHarness( move( test_name ),
                    "capacity=" + std::to_string( capacity ),
-                   { TCPReceiver { Reassembler { ByteStream { capacity } } } } )
+                   { TCPReceiver { Reassembler { ByteStream { capacity, storage } } } } )
+  {}
+
+  TCPReceiverTestHarness( std::string test_name, uint64_t capacity, uint8_t window_scale )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ) + ", window_scale=" + std::to_string( window_scale ),
+                   { TCPReceiver { Reassembler { ByteStream { capacity } }, window_scale } } )
   {}
 
   template<std::derived_from<TestStep<Reassembler>> T>
@@ -61,11 +72,11 @@ public:
   using TestHarness<TCPReceiver>::execute;
 };
 
-struct ExpectWindow : public ExpectNumber<TCPReceiver, uint16_t>
+struct ExpectWindow : public ExpectNumber<TCPReceiver, uint32_t>
 {
   using ExpectNumber::ExpectNumber;
   std::string name() const override { return "window_size"; }
-  uint16_t value( TCPReceiver& rs ) const override { return rs.send().window_size; }
+  uint32_t value( TCPReceiver& rs ) const override { return rs.send().window_size; }
 };
 
 struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
@@ -111,6 +122,50 @@ struct ExpectAcknoBetween : public Expectation<TCPReceiver>
   }
 };
 
+struct ExpectSACKBlocks : public Expectation<TCPReceiver>
+{
+  std::vector<SACKBlock> blocks_;
+  explicit ExpectSACKBlocks( std::vector<SACKBlock> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string describe( const std::vector<SACKBlock>& blocks )
+  {
+    std::string ret = "[";
+    for ( const auto& block : blocks ) {
+      ret += " " + to_string( block.left ) + "-" + to_string( block.right );
+    }
+    return ret + " ]";
+  }
+
+  std::string description() const override { return "SACK blocks = " + describe( blocks_ ); }
+
+  void execute( TCPReceiver& rs ) const override
+  {
+    const auto blocks = rs.send().sack_blocks;
+    const auto same_block = []( const SACKBlock& a, const SACKBlock& b ) {
+      return a.left == b.left and a.right == b.right;
+    };
+    const bool same = std::equal( blocks.begin(), blocks.end(), blocks_.begin(), blocks_.end(), same_block );
+    if ( not same ) {
+      throw ExpectationViolation( "TCPReceiver reported SACK blocks " + describe( blocks ) + ", but expected "
+                                  + describe( blocks_ ) );
+    }
+  }
+};
+
+struct ExpectTimestampEcho : public ExpectNumber<TCPReceiver, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "timestamp_echo"; }
+  std::optional<uint32_t> value( TCPReceiver& rs ) const override { return rs.send().timestamp_echo; }
+};
+
+struct ExpectPAWSRejected : public ExpectNumber<TCPReceiver, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "paws_rejected"; }
+  uint64_t value( TCPReceiver& rs ) const override { return rs.paws_rejected(); }
+};
+
 struct HasAckno : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
@@ -141,6 +196,24 @@ struct SegmentArrives : public Action<TCPReceiver>
     return *this;
   }
 
+  SegmentArrives& with_sack_permitted()
+  {
+    msg_.SACK_permitted = true;
+    return *this;
+  }
+
+  SegmentArrives& with_window_scale( uint8_t shift )
+  {
+    msg_.window_scale = shift;
+    return *this;
+  }
+
+  SegmentArrives& with_timestamp( uint32_t timestamp )
+  {
+    msg_.timestamp = timestamp;
+    return *this;
+  }
+
   SegmentArrives& with_seqno( Wrap32 seqno_ )
   {
     msg_.seqno = seqno_;
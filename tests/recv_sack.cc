@@ -0,0 +1,69 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no SACK blocks unless the SYN permits them", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACKBlocks { {} } );
+    }
+
+    for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks report the held ranges, latest first", 4000, storage };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+      test.execute( ExpectSACKBlocks { {} } );
+
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "jklm" ) );
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 10 }, Wrap32 { isn + 14 } } } } );
+
+      test.execute( SegmentArrives {}.with_seqno( isn + 20 ).with_data( "tu" ) );
+      test.execute( ExpectSACKBlocks {
+        { { Wrap32 { isn + 20 }, Wrap32 { isn + 22 } }, { Wrap32 { isn + 10 }, Wrap32 { isn + 14 } } } } );
+
+      // adjacent ranges merge into one block
+      test.execute( SegmentArrives {}.with_seqno( isn + 14 ).with_data( "nop" ) );
+      test.execute( ExpectSACKBlocks {
+        { { Wrap32 { isn + 10 }, Wrap32 { isn + 17 } }, { Wrap32 { isn + 20 }, Wrap32 { isn + 22 } } } } );
+
+      // filling the first hole acknowledges that block
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcdefghi" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 17 } } );
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 20 }, Wrap32 { isn + 22 } } } } );
+      test.execute( ReadAll { "abcdefghijklmnop" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "at most four SACK blocks", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ) );
+      for ( uint32_t i = 1; i <= 5; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 10 * i ).with_data( "x" ) );
+      }
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 50 }, Wrap32 { isn + 51 } },
+                                         { Wrap32 { isn + 10 }, Wrap32 { isn + 11 } },
+                                         { Wrap32 { isn + 20 }, Wrap32 { isn + 21 } },
+                                         { Wrap32 { isn + 30 }, Wrap32 { isn + 31 } } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
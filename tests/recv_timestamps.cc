@@ -0,0 +1,80 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no echo unless the SYN carries a timestamp", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 5 ) );
+      test.execute( ExpectTimestampEcho { nullopt } );
+      test.execute( BytesPushed { 4 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "echo the timestamp of in-order segments", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 100 ) );
+      test.execute( ExpectTimestampEcho { 100 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 110 ) );
+      test.execute( ExpectTimestampEcho { 110 } );
+
+      // an out-of-order segment's timestamp isn't echoed, but the one filling the hole is
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_timestamp( 130 ) );
+      test.execute( ExpectTimestampEcho { 110 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_timestamp( 120 ) );
+      test.execute( ExpectTimestampEcho { 120 } );
+      test.execute( BytesPushed { 12 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS rejects segments stamped before the latest", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( UINT32_MAX - 10 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 5 ) );
+      test.execute( ExpectTimestampEcho { 5 } );
+
+      // an old duplicate (from before the timestamp clock wrapped) is dropped, whatever its sequence numbers
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "OLD!" ).with_timestamp( UINT32_MAX - 5 ) );
+      test.execute( ExpectPAWSRejected { 1 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ExpectTimestampEcho { 5 } );
+
+      // ... and segments with the same timestamp, or a later one, are still accepted
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_timestamp( 5 ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_timestamp( 6 ) );
+      test.execute( ReadAll { "abcdefghijkl" } );
+      test.execute( ExpectPAWSRejected { 1 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "fewer SACK blocks fit alongside a timestamp", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_sack_permitted().with_seqno( isn ).with_timestamp( 1 ) );
+      for ( uint32_t i = 0; i < 5; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 11 + 10 * i ).with_data( "x" ).with_timestamp( 2 ) );
+      }
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 51 }, Wrap32 { isn + 52 } },
+                                         { Wrap32 { isn + 11 }, Wrap32 { isn + 12 } },
+                                         { Wrap32 { isn + 21 }, Wrap32 { isn + 22 } } } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,69 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+#include "tcp_config.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      if ( cfg.window_scale() != 0 ) {
+        throw runtime_error( "the default capacity shouldn't need window scaling" );
+      }
+      cfg.recv_capacity = 1000000;
+      if ( cfg.window_scale() != 4 ) {
+        throw runtime_error( "a 1 MB capacity needs a window scale of 4" );
+      }
+      cfg.recv_capacity = SIZE_MAX;
+      if ( cfg.window_scale() != TCPConfig::MAX_WINDOW_SCALE ) {
+        throw runtime_error( "window scale is limited to 14" );
+      }
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "window limited to 16 bits unless the SYN offers scaling", 1000000, 4 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "scaled window covers the capacity", 1000000, 4 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 0 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { 1000000 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 100000, 'x' ) ) );
+      test.execute( ExpectWindow { 900000 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "scaled window limited by the shift", 2000000, 4 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 7 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { UINT16_MAX << 4 } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no scaling unless this end offers it", 1000000 };
+      test.execute( SegmentArrives {}.with_syn().with_window_scale( 4 ).with_seqno( isn ) );
+      test.execute( ExpectWindow { UINT16_MAX } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,187 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "No congestion control leaves the window to the receiver", cfg };
+      test.execute( ExpectCongestionWindow { UINT64_MAX } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 10 * mss ) );
+      test.execute( Push { string( 10 * mss, 'x' ) } );
+      test.execute( ExpectSeqnosInFlight { 10 * mss } );
+    }
+
+    const auto algorithms = { CongestionControl::Reno, CongestionControl::NewReno, CongestionControl::Cubic };
+    for ( const auto algorithm : algorithms ) {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Slow start, then collapse on timeout", cfg, algorithm };
+      test.execute( ExpectCongestionWindow { 4 * mss } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+
+      // the SYN's acknowledgment grows the window by one sequence number
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ) );
+      test.execute( ExpectCongestionWindow { 4 * mss + 1 } );
+      test.execute( Push { string( 20 * mss, 'x' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 4 * mss + 1 } );
+
+      // an acknowledgment grows the window by at most one segment, however much it acknowledges
+      test.execute( AckReceived { Wrap32 { isn + 1 + 2 * mss } }.with_win( 20 * mss ) );
+      test.execute( ExpectCongestionWindow { 5 * mss + 1 } );
+      for ( int i = 0; i < 3; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 5 * mss + 1 } );
+
+      // a timeout collapses the window to one segment
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + 2 * mss ) );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectSeqnosInFlight { 5 * mss + 1 } );
+
+      // ... and nothing more is sent until the window opens up again
+      test.execute( AckReceived { Wrap32 { isn + 1 + 3 * mss } }.with_win( 20 * mss ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Fast retransmit and recovery", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + i * mss ) );
+      }
+
+      // the first and third segments are lost: the third duplicate ack resends the first, long before the RTO
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 5 * mss } );
+
+      // a partial acknowledgment resends the next hole right away, staying in recovery
+      test.execute( AckReceived { Wrap32 { isn + 1 + 2 * mss } }.with_win( 20 * mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + 2 * mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 4 * mss } );
+
+      // ... and acknowledging everything ends recovery, at the reduced window
+      test.execute( AckReceived { Wrap32 { isn + 1 + 4 * mss } }.with_win( 20 * mss ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "SACK fills every hole within a round trip", cfg, CongestionControl::NewReno };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( int i = 0; i < 4; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + i * mss ) );
+      }
+
+      // the first and third segments are lost, and the receiver reports holding the others
+      const SACKBlock second { isn + 1 + mss, isn + 1 + 2 * mss };
+      const SACKBlock fourth { isn + 1 + 3 * mss, isn + 1 + 4 * mss };
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ).with_sack( { second } ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ).with_sack( { fourth, second } ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ).with_sack( { fourth, second } ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // the next duplicate resends the other hole (skipping the segment the receiver has), without waiting
+      // for a partial acknowledgment
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ).with_sack( { fourth, second } ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + 2 * mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ).with_sack( { fourth, second } ) );
+      test.execute( ExpectNoSegment {} );
+
+      // ... so the partial acknowledgment has nothing left to resend
+      test.execute( AckReceived { Wrap32 { isn + 1 + 2 * mss } }.with_win( 20 * mss ).with_sack( { fourth } ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 4 * mss } }.with_win( 20 * mss ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "BBR paces segments out in tick()", cfg, CongestionControl::BBR };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+
+      // the first RTT sample (10 ms) sets the pacing rate to 2.885 x the initial window per RTT (1154 bytes/ms)
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20 * mss ) );
+      test.execute( Push { string( 20 * mss, 'x' ) } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 2 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+
+      // ... and the (initial) congestion window still applies
+      test.execute( ExpectSeqnosInFlight { 4 * mss } );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Nagle holds small writes while data is in flight", cfg };
+      test.execute( SetNagle { true } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 10 * mss ) );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "b" } );
+      test.execute( Push { "c" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 1 } );
+
+      // the acknowledgment lets the held bytes go, together
+      test.execute( AckReceived { Wrap32 { isn + 2 } }.with_win( 10 * mss ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "bc" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // a full segment goes right away, but the short rest waits
+      test.execute( Push { string( mss + 500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // ... unless it's the end of the stream
+      test.execute( Close {} );
+      test.execute( ExpectMessage {}.with_fin( true ).with_payload_size( 500 ).with_seqno( isn + 4 + mss ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Corking holds short segments until uncorked", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 10 * mss ) );
+      test.execute( Cork {} );
+      test.execute( Push { "hello" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 5UL * cfg.rt_timeout } );
+      test.execute( ExpectNoSegment {} );
+
+      // full segments still go
+      test.execute( Push { string( mss, 'x' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // uncorking sends the rest, even with data in flight
+      test.execute( Uncork {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 5 ).with_seqno( isn + 1 + mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push { "!" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "!" ).with_seqno( isn + 6 + mss ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
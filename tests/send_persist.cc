@@ -0,0 +1,89 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Zero-window probes are counted, but aren't retransmissions", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectZeroWindowProbes { 1 } );
+      for ( int i = 0; i < 10; ++i ) {
+        test.execute( Tick { cfg.rt_timeout } );
+        test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      }
+      test.execute( ExpectZeroWindowProbes { 11 } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+      test.execute( ExpectPersistTimeout { cfg.rt_timeout } );
+
+      // a window update resumes sending right away, and the retransmission timer takes over
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 10 ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "bc" ).with_seqno( isn + 2 ) );
+      test.execute( Tick { cfg.rt_timeout - 1UL } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectConsecutiveRetransmissions { 1 } );
+      test.execute( ExpectZeroWindowProbes { 11 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test {
+        "With an adaptive RTO, probes back off", cfg, CongestionControl::NewReno, RTOLimits { 200, 5000 } };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 0 ) );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      // (the SYN's immediate acknowledgment took the RTO down to the minimum)
+      test.execute( ExpectPersistTimeout { 200 } );
+
+      for ( const uint64_t wait : { 200, 400, 800, 1600, 3200, 5000, 5000 } ) {
+        test.execute( Tick { wait - 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      }
+      test.execute( ExpectZeroWindowProbes { 8 } );
+
+      // ... without congestion control taking them for losses
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+      test.execute( ExpectCongestionWindow { 4 * mss + 1 } );
+
+      // the receiver taking the probe's byte starts the schedule over
+      test.execute( AckReceived { Wrap32 { isn + 2 } }.with_win( 0 ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectPersistTimeout { 200 } );
+      test.execute( Tick { 200 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "b" ).with_seqno( isn + 2 ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const RTOLimits limits { TCPConfig::MIN_RTO_MS, TCPConfig::MAX_RTO_MS };
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "RTO follows the measured RTT", cfg, CongestionControl::None, limits };
+      test.execute( ExpectSmoothedRTT { nullopt } );
+      test.execute( ExpectRTO { cfg.rt_timeout } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+
+      // first sample: SRTT = 100, RTTVAR = 50, so RTO = 100 + 4 * 50
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTO { 300 } );
+
+      // next: RTTVAR = 3/4 * 50 + 1/4 * |100 - 60| = 47.5, SRTT = 7/8 * 100 + 1/8 * 60 = 95
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 60 } );
+      test.execute( AckReceived { Wrap32 { isn + 2 } }.with_win( 1000 ) );
+      test.execute( ExpectSmoothedRTT { 95 } );
+      test.execute( ExpectRTO { 285 } );
+
+      // a retransmitted segment's acknowledgment gives no sample (Karn's rule)
+      test.execute( Push { "b" } );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( Tick { 284 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectRTO { 570 } );
+      test.execute( Tick { 5 } );
+      test.execute( AckReceived { Wrap32 { isn + 3 } }.with_win( 1000 ) );
+      test.execute( ExpectSmoothedRTT { 95 } );
+      test.execute( ExpectRTO { 285 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "RTO doesn't fall below the minimum", cfg, CongestionControl::None, limits };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectSmoothedRTT { 10 } );
+      test.execute( ExpectRTO { TCPConfig::MIN_RTO_MS } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test {
+        "Backoff stops at the maximum RTO", cfg, CongestionControl::None, RTOLimits { 200, 1500 } };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { 1500 } );
+      test.execute( Tick { 1499 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { 1500 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Without limits, the RTO stays put", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectSmoothedRTT { 100 } );
+      test.execute( ExpectRTO { cfg.rt_timeout } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test {
+        "Timestamp echoes measure retransmissions too", cfg, CongestionControl::None, limits };
+      test.execute( SetTimestamps {} );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ).with_timestamp( 0 ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ).with_timestamp_echo( 0 ) );
+      test.execute( ExpectSmoothedRTT { 100 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 100 ) );
+      test.execute( Tick { 300 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_timestamp( 400 ) );
+
+      // the echo says the ack answers the retransmission, 20 ms ago (not the original, 320 ms ago)
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_win( 1000 ).with_timestamp_echo( 400 ) );
+      test.execute( ExpectSmoothedRTT { 90 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -167,6 +167,33 @@ int main()
       test.execute( ExpectSeqno { Wrap32 { isn + 1 + 3 } } );
     }
 
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.send_capacity = 100000;
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+      TCPSenderTestHarness test { "A batched push sends the whole burst at once", cfg };
+      test.execute( Push {}.with_batch() );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectLastBatchSize { 1 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 64 * mss ) );
+      test.execute( Push { string( 64 * mss + 10, 'x' ) }.with_close().with_batch() );
+      test.execute( ExpectBatchCount { 2 } );
+      test.execute( ExpectLastBatchSize { 64 } );
+      for ( uint64_t i = 0; i < 64; ++i ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + i * mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 64 * mss } );
+
+      // the rest (and the FIN) go out together once the window opens
+      test.execute( AckReceived { Wrap32 { isn + 1 + 64 * mss } }.with_win( 64 * mss ) );
+      test.execute( ExpectMessage {}.with_fin( true ).with_payload_size( 10 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
@@ -9,8 +9,10 @@
 
 #include <optional>
 #include <queue>
+#include <span>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -18,11 +20,22 @@ struct SenderAndOutput
 {
   TCPSender sender;
   std::queue<TCPSenderMessage> output {};
+  std::vector<size_t> batch_sizes {};
 
   auto make_transmit()
   {
     return [&]( const TCPSenderMessage& x ) { output.push( x ); };
   }
+
+  auto make_transmit_batch()
+  {
+    return [&]( std::span<const TCPSenderMessage> batch ) {
+      batch_sizes.push_back( batch.size() );
+      for ( const auto& x : batch ) {
+        output.push( x );
+      }
+    };
+  }
 };
 
 inline std::string to_string( const TCPSenderMessage& msg )
@@ -66,6 +79,23 @@ struct ExpectReset : public ExpectBool<SenderAndOutput>
   bool value( SenderAndOutput& ss ) const override { return ss.sender.make_empty_message().RST; }
 };
 
+struct ExpectLastBatchSize : public ExpectNumber<SenderAndOutput, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "size of the latest batch transmitted"; }
+  size_t value( SenderAndOutput& ss ) const override
+  {
+    return ss.batch_sizes.empty() ? 0 : ss.batch_sizes.back();
+  }
+};
+
+struct ExpectBatchCount : public ExpectNumber<SenderAndOutput, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "number of batches transmitted"; }
+  size_t value( SenderAndOutput& ss ) const override { return ss.batch_sizes.size(); }
+};
+
 struct ExpectSeqnosInFlight : public ExpectNumber<SenderAndOutput, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
@@ -80,6 +110,41 @@ struct ExpectConsecutiveRetransmissions : public ExpectNumber<SenderAndOutput, u
   uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.consecutive_retransmissions(); }
 };
 
+struct ExpectZeroWindowProbes : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "zero_window_probes"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.zero_window_probes(); }
+};
+
+struct ExpectPersistTimeout : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "persist_timeout_ms"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.persist_timeout_ms(); }
+};
+
+struct ExpectCongestionWindow : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "congestion_window"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.congestion_window(); }
+};
+
+struct ExpectSmoothedRTT : public ExpectNumber<SenderAndOutput, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "smoothed_rtt_ms"; }
+  std::optional<uint64_t> value( SenderAndOutput& ss ) const override { return ss.sender.smoothed_rtt_ms(); }
+};
+
+struct ExpectRTO : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "current_RTO_ms"; }
+  uint64_t value( SenderAndOutput& ss ) const override { return ss.sender.current_RTO_ms(); }
+};
+
 struct ExpectNoSegment : public Expectation<SenderAndOutput>
 {
   std::string description() const override { return "nothing to send"; }
@@ -108,6 +173,7 @@ struct Push : public Action<SenderAndOutput>
 {
   std::string data_;
   bool close_ {};
+  bool batch_ {};
 
   explicit Push( std::string data = "" ) : data_( move( data ) ) {}
   std::string description() const override
@@ -121,7 +187,7 @@ struct Push : public Action<SenderAndOutput>
     }
 
     return "push \"" + Printer::prettify( data_ ) + "\" to stream" + ( close_ ? ", close it" : "" )
-           + ", then push to TCPSender";
+           + ", then push to TCPSender" + ( batch_ ? " (batched)" : "" );
   }
   void execute( SenderAndOutput& ss ) const override
   {
@@ -131,7 +197,11 @@ struct Push : public Action<SenderAndOutput>
     if ( close_ ) {
       ss.sender.writer().close();
     }
-    ss.sender.push( ss.make_transmit() );
+    if ( batch_ ) {
+      ss.sender.push_batch( ss.make_transmit_batch() );
+    } else {
+      ss.sender.push( ss.make_transmit() );
+    }
   }
 
   Push& with_close()
@@ -139,6 +209,58 @@ struct Push : public Action<SenderAndOutput>
     close_ = true;
     return *this;
   }
+
+  Push& with_batch()
+  {
+    batch_ = true;
+    return *this;
+  }
+};
+
+struct SetMSS : public Action<SenderAndOutput>
+{
+  size_t mss_;
+  bool super_segments_;
+
+  explicit SetMSS( size_t mss, bool super_segments = false ) : mss_( mss ), super_segments_( super_segments ) {}
+
+  std::string description() const override
+  {
+    return "set MSS to " + std::to_string( mss_ ) + ( super_segments_ ? " with super-segments" : "" );
+  }
+
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_mss( mss_, super_segments_ ); }
+};
+
+struct SetNagle : public Action<SenderAndOutput>
+{
+  bool enabled_;
+
+  explicit SetNagle( bool enabled ) : enabled_( enabled ) {}
+  std::string description() const override { return std::string( enabled_ ? "enable" : "disable" ) + " Nagle"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_nagle( enabled_ ); }
+};
+
+struct SetTimestamps : public Action<SenderAndOutput>
+{
+  std::string description() const override { return "enable timestamps"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.set_timestamps( true ); }
+};
+
+struct Cork : public Action<SenderAndOutput>
+{
+  std::string description() const override { return "cork TCPSender"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.cork(); }
+};
+
+struct Uncork : public Action<SenderAndOutput>
+{
+  std::string description() const override { return "uncork TCPSender, then push"; }
+  void execute( SenderAndOutput& ss ) const override
+  {
+    ss.sender.uncork();
+    ss.sender.push( ss.make_transmit() );
+  }
 };
 
 struct Tick : public Action<SenderAndOutput>
@@ -199,12 +321,24 @@ struct Receive : public Action<SenderAndOutput>
     return desc.str();
   }
 
-  Receive& with_win( uint16_t win )
+  Receive& with_win( uint32_t win )
   {
     msg_.window_size = win;
     return *this;
   }
 
+  Receive& with_sack( std::vector<SACKBlock> blocks )
+  {
+    msg_.sack_blocks = std::move( blocks );
+    return *this;
+  }
+
+  Receive& with_timestamp_echo( uint32_t echo )
+  {
+    msg_.timestamp_echo = echo;
+    return *this;
+  }
+
   void execute( SenderAndOutput& ss ) const override
   {
     ss.sender.receive( msg_ );
@@ -238,6 +372,7 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<std::optional<uint32_t>> timestamp {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -271,6 +406,12 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
 
   ExpectMessage& with_seqno( uint32_t seqno_ ) { return with_seqno( Wrap32 { seqno_ } ); }
 
+  ExpectMessage& with_timestamp( std::optional<uint32_t> timestamp_ )
+  {
+    timestamp = timestamp_;
+    return *this;
+  }
+
   ExpectMessage& with_payload_size( size_t payload_size_ )
   {
     payload_size = payload_size_;
@@ -308,6 +449,9 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( rst.has_value() ) {
       o << ( rst.value() ? " +RST" : " (no RST)" );
     }
+    if ( timestamp.has_value() ) {
+      o << " timestamp=" << to_string( timestamp.value() );
+    }
     return o.str();
   }
 
@@ -337,10 +481,13 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
     if ( seqno.has_value() and seg.seqno != seqno.value() ) {
       throw ExpectationViolation( "sequence number", seqno.value(), seg.seqno );
     }
+    if ( timestamp.has_value() and seg.timestamp != timestamp.value() ) {
+      throw ExpectationViolation( "timestamp", timestamp.value(), seg.timestamp );
+    }
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    if ( seg.payload.size() > ss.sender.max_payload_size() ) {
       throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
                                   + ") greater than the maximum" );
     }
@@ -356,9 +503,16 @@ struct ExpectMessage : public Expectation<SenderAndOutput>
 class TCPSenderTestHarness : public TestHarness<SenderAndOutput>
 {
 public:
-  TCPSenderTestHarness( std::string name, TCPConfig config )
+  TCPSenderTestHarness( std::string name,
+                        TCPConfig config,
+                        CongestionControl congestion_control = CongestionControl::None,
+                        std::optional<RTOLimits> RTO_limits = {} )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { TCPSender { ByteStream { config.send_capacity },
+                                 config.isn,
+                                 config.rt_timeout,
+                                 congestion_control,
+                                 RTO_limits } } )
   {}
 };
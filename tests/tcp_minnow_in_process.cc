@@ -0,0 +1,272 @@
+#include "exception.hh"
+#include "parser.hh"
+#include "tcp_minnow_socket_impl.hh"
+#include "tcp_over_ip.hh"
+
+#include <array>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+
+using namespace std;
+
+// Carries IPv4 datagrams to and from the other socket over one end of a datagram socket pair
+class LoopbackAdapter : public TCPOverIPv4Adapter
+{
+  FileDescriptor socket_;
+
+public:
+  explicit LoopbackAdapter( FileDescriptor&& socket ) : socket_( std::move( socket ) ) {}
+
+  optional<TCPMessage> read()
+  {
+    vector<string> strs( 2 );
+    strs.front().resize( IPv4Header::LENGTH );
+    socket_.read( strs );
+
+    InternetDatagram ip_dgram;
+    const vector<string> buffers = { strs.at( 0 ), strs.at( 1 ) };
+    if ( parse( ip_dgram, buffers ) ) {
+      return unwrap_tcp_in_ip( ip_dgram );
+    }
+    return {};
+  }
+
+  void write( const TCPMessage& msg )
+  {
+    for ( const auto& dgram : wrap_tcp_in_ip_segments( msg ) ) {
+      socket_.write( serialize( dgram ) );
+    }
+  }
+
+  FileDescriptor& fd() { return socket_; }
+};
+
+using LoopbackMinnowSocket = TCPMinnowSocket<LoopbackAdapter>;
+
+static pair<FileDescriptor, FileDescriptor> make_datagram_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_DGRAM, 0, fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// Sleep until the eventfd is readable
+static void wait_for( EventFD& event )
+{
+  pollfd pfd { event.fd_num(), POLLIN, 0 };
+  if ( ::poll( &pfd, 1, 5000 ) != 1 ) {
+    throw runtime_error( "timed out waiting for in-process stream event" );
+  }
+}
+
+static string random_string( size_t len, size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  for ( size_t i = 0; i < len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+// Push `data` to the socket's outbound stream and close it, while popping its inbound stream to the end
+static string exchange( LoopbackMinnowSocket& sock, const string& data )
+{
+  exception_ptr writer_error;
+  thread writer { [&] {
+    try {
+      SPSCByteStream& outbound = sock.outbound_stream();
+      size_t pushed = 0;
+      while ( pushed < data.size() ) {
+        const size_t n = outbound.push( string_view { data }.substr( pushed ) );
+        if ( n == 0 and outbound.prepare_wait_for_space() ) {
+          wait_for( outbound.space_event() );
+        }
+        pushed += n;
+      }
+      outbound.close();
+    } catch ( ... ) {
+      writer_error = current_exception();
+    }
+  } };
+
+  SPSCByteStream& inbound = sock.inbound_stream();
+  string received;
+  while ( not inbound.is_finished() and not inbound.has_error() ) {
+    if ( inbound.bytes_buffered() == 0 ) {
+      if ( inbound.prepare_wait_for_data() ) {
+        wait_for( inbound.data_event() );
+      }
+      continue;
+    }
+    const auto piece = inbound.peek_both().first;
+    received += piece;
+    inbound.pop( piece.size() );
+  }
+
+  writer.join();
+  if ( writer_error ) {
+    rethrow_exception( writer_error );
+  }
+  if ( inbound.has_error() ) {
+    throw runtime_error( "inbound stream had an error" );
+  }
+  return received;
+}
+
+// Connect two in-process sockets to each other over a datagram socket pair
+static void connect_pair( LoopbackMinnowSocket& client, LoopbackMinnowSocket& server )
+{
+  TCPConfig tcp_config;
+  tcp_config.rt_timeout = 100;
+
+  FdAdapterConfig client_config;
+  client_config.source = Address { "10.0.0.1", 40144 };
+  client_config.destination = Address { "10.0.0.2", 1234 };
+
+  FdAdapterConfig server_config;
+  server_config.source = Address { "10.0.0.2", 1234 };
+
+  thread acceptor { [&] { server.listen_and_accept( tcp_config, server_config ); } };
+  client.connect( tcp_config, client_config );
+  acceptor.join();
+}
+
+// Move data both ways through two in-process sockets, then close them cleanly
+void exchange_test( size_t client_len, size_t server_len, uint64_t server_capacity )
+{
+  auto [client_end, server_end] = make_datagram_pair();
+  LoopbackMinnowSocket client { LoopbackAdapter { std::move( client_end ) } };
+  LoopbackMinnowSocket server { LoopbackAdapter { std::move( server_end ) } };
+  client.use_in_process_streams();
+  server.use_in_process_streams( server_capacity );
+
+  bool socket_pair_refused = false;
+  try {
+    client.write( "should not go to the socket pair" );
+  } catch ( const runtime_error& ) {
+    socket_pair_refused = true;
+  }
+  if ( not socket_pair_refused ) {
+    throw runtime_error( "write() should fail in in-process mode" );
+  }
+
+  connect_pair( client, server );
+
+  const string client_data = random_string( client_len, client_len );
+  const string server_data = random_string( server_len, server_len + 1 );
+  string from_client;
+  exception_ptr server_error;
+  thread server_thread { [&] {
+    try {
+      from_client = exchange( server, server_data );
+    } catch ( ... ) {
+      server_error = current_exception();
+    }
+  } };
+  const string from_server = exchange( client, client_data );
+  server_thread.join();
+  if ( server_error ) {
+    rethrow_exception( server_error );
+  }
+
+  if ( from_client != client_data ) {
+    throw runtime_error( "server received " + to_string( from_client.size() ) + " bytes, expected "
+                         + to_string( client_data.size() ) );
+  }
+  if ( from_server != server_data ) {
+    throw runtime_error( "client received " + to_string( from_server.size() ) + " bytes, expected "
+                         + to_string( server_data.size() ) );
+  }
+
+  client.wait_until_closed();
+  server.wait_until_closed();
+}
+
+// While the client is corked, a short write stays back; uncorking sends it
+void cork_test()
+{
+  auto [client_end, server_end] = make_datagram_pair();
+  LoopbackMinnowSocket client { LoopbackAdapter { std::move( client_end ) } };
+  LoopbackMinnowSocket server { LoopbackAdapter { std::move( server_end ) } };
+  client.use_in_process_streams();
+  server.use_in_process_streams();
+  connect_pair( client, server );
+
+  client.cork();
+  client.outbound_stream().push( "corked" );
+  this_thread::sleep_for( chrono::milliseconds( 100 ) );
+  if ( server.inbound_stream().bytes_buffered() != 0 ) {
+    throw runtime_error( "a short write went out while corked" );
+  }
+
+  client.uncork();
+  SPSCByteStream& inbound = server.inbound_stream();
+  while ( inbound.bytes_buffered() < 6 ) {
+    if ( inbound.prepare_wait_for_data() ) {
+      wait_for( inbound.data_event() );
+    }
+  }
+  if ( inbound.peek_both().first != "corked" ) {
+    throw runtime_error( "server received the wrong bytes after uncorking" );
+  }
+  inbound.pop( 6 );
+
+  exception_ptr server_error;
+  thread server_thread { [&] {
+    try {
+      exchange( server, {} );
+    } catch ( ... ) {
+      server_error = current_exception();
+    }
+  } };
+  exchange( client, {} );
+  server_thread.join();
+  if ( server_error ) {
+    rethrow_exception( server_error );
+  }
+  client.wait_until_closed();
+  server.wait_until_closed();
+}
+
+// An error on the owner's outbound stream ends the connection and shows up on its inbound stream
+void error_test()
+{
+  auto [client_end, server_end] = make_datagram_pair();
+  LoopbackMinnowSocket client { LoopbackAdapter { std::move( client_end ) } };
+  LoopbackMinnowSocket server { LoopbackAdapter { std::move( server_end ) } };
+  client.use_in_process_streams();
+  server.use_in_process_streams();
+  connect_pair( client, server );
+
+  client.outbound_stream().set_error();
+  client.wait_until_closed();
+
+  if ( not client.inbound_stream().has_error() or not client.inbound_stream().is_closed() ) {
+    throw runtime_error( "outbound error did not reach the inbound stream" );
+  }
+}
+
+int main()
+{
+  try {
+    exchange_test( 0, 0, TCPConfig::DEFAULT_CAPACITY );
+    exchange_test( 100000, 3000, TCPConfig::DEFAULT_CAPACITY );
+    exchange_test( 200000, 200000, 1000 );
+    cork_test();
+    error_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,96 @@
+#include "tcp_config.hh"
+#include "tcp_peer_test_harness.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPPeerTestHarness test { "one acknowledgment covers every second segment, the timer a lone one",
+                                TCPConfig {} };
+      test.execute( ClientMessages { 0 } );
+      test.execute( ServerMessages { 0 } );
+      test.execute( ClientSends { 3 } );
+      test.execute( ClientMessages { 3 } );
+      test.execute( DeliverToServer { 0 } );
+      test.execute( ServerMessages { 0 } );
+      test.execute( DeliverToServer { 1 } );
+      test.execute( ServerMessages { 1 } );
+      test.execute( LastAckCovers { 2 * mss } );
+
+      test.execute( DeliverToServer { 2 } );
+      test.execute( ServerTick { TCPConfig::DELAYED_ACK_DFLT - 1 } );
+      test.execute( ServerMessages { 1 } );
+      test.execute( ServerTick { 1 } );
+      test.execute( ServerMessages { 2 } );
+      test.execute( LastAckCovers { 3 * mss } );
+      test.execute( ServerTick { 1000 } );
+      test.execute( ServerMessages { 2 } );
+    }
+
+    {
+      TCPPeerTestHarness test { "out-of-order data, and the segment filling the hole, are acknowledged right away",
+                                TCPConfig {} };
+      test.execute( ClientSends { 2 } );
+      test.execute( DeliverToServer { 1 } );
+      test.execute( ServerMessages { 1 } );
+      test.execute( LastAckCovers { 0 } );
+      test.execute( DeliverToServer { 0 } );
+      test.execute( ServerMessages { 2 } );
+      test.execute( LastAckCovers { 2 * mss } );
+      test.execute( ServerBytesBuffered { 2 * mss } );
+    }
+
+    {
+      TCPPeerTestHarness test { "outgoing data carries a pending acknowledgment", TCPConfig {} };
+      test.execute( ClientSends { 1 } );
+      test.execute( DeliverToServer { 0 } );
+      test.execute( ServerMessages { 0 } );
+      test.execute( ServerSends { "reply" } );
+      test.execute( ServerMessages { 1 } );
+      test.execute( LastPayload { "reply" } );
+      test.execute( LastAckCovers { mss } );
+      test.execute( ServerTick { TCPConfig::DELAYED_ACK_DFLT } );
+      test.execute( ServerMessages { 1 } );
+    }
+
+    {
+      TCPConfig client_cfg;
+      client_cfg.mss = 500;
+      TCPPeerTestHarness test { "every second segment is acknowledged at the MSS the peers agreed on", client_cfg,
+                                TCPConfig {} };
+      test.execute( ClientSends { 3 } );
+      test.execute( ClientMessages { 3 } );
+      test.execute( DeliverToServer { 0 } );
+      test.execute( ServerMessages { 0 } );
+      test.execute( DeliverToServer { 1 } );
+      test.execute( ServerMessages { 1 } );
+      test.execute( LastAckCovers { 2 * 500 } );
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.delayed_ack_ms = 0;
+      TCPPeerTestHarness test { "with delayed acknowledgments turned off, every segment gets its own", cfg };
+      test.execute( ClientSends { 2 } );
+      test.execute( DeliverToServer { 0 } );
+      test.execute( ServerMessages { 1 } );
+      test.execute( LastAckCovers { mss } );
+      test.execute( DeliverToServer { 1 } );
+      test.execute( ServerMessages { 2 } );
+      test.execute( LastAckCovers { 2 * mss } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,34 @@
+#include "tcp_config.hh"
+#include "tcp_peer_test_harness.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+    // slow start grows the initial window by a byte for the SYN, and an MSS for the ACK of two segments
+    constexpr uint64_t grown_window = ( RenoController::INITIAL_WINDOW + 1 ) * mss + 1;
+
+    {
+      TCPPeerTestHarness test { "a retransmitted SYN-ACK doesn't restart congestion control", TCPConfig {} };
+      test.execute( ClientSends { 2 } );
+      test.execute( DeliverToServer { 0 } );
+      test.execute( DeliverToServer { 1 } );
+      test.execute( ServerMessages { 1 } );
+      test.execute( DeliverToClient {} );
+      test.execute( ClientCongestionWindow { grown_window } );
+      test.execute( RedeliverSynAck {} );
+      test.execute( ClientCongestionWindow { grown_window } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
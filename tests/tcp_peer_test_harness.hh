@@ -0,0 +1,201 @@
+#pragma once
+
+#include "common.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Two connected peers, with the messages each has sent (but not yet delivered)
+struct TCPPeerPair
+{
+  TCPPeer client;
+  TCPPeer server;
+  std::vector<TCPMessage> from_client {};
+  std::vector<TCPMessage> from_server {};
+  TCPMessage syn_ack {};
+
+  TCPPeer::TransmitFunction to_server()
+  {
+    return [this]( const TCPMessage& msg ) { from_client.push_back( msg ); };
+  }
+  TCPPeer::TransmitFunction to_client()
+  {
+    return [this]( const TCPMessage& msg ) { from_server.push_back( msg ); };
+  }
+
+  void deliver_to_server()
+  {
+    for ( auto msgs = std::move( from_client ); auto& msg : msgs ) {
+      server.receive( std::move( msg ), to_client() );
+    }
+  }
+  void deliver_to_client()
+  {
+    for ( auto msgs = std::move( from_server ); auto& msg : msgs ) {
+      client.receive( std::move( msg ), to_server() );
+    }
+  }
+
+  // Two peers that have finished the handshake
+  static TCPPeerPair connected( const TCPConfig& client_cfg, const TCPConfig& server_cfg )
+  {
+    TCPPeerPair pair { TCPPeer { client_cfg }, TCPPeer { server_cfg } };
+    pair.client.push( pair.to_server() );
+    pair.deliver_to_server();
+    pair.syn_ack = pair.from_server.at( 0 );
+    pair.deliver_to_client();
+    pair.deliver_to_server();
+    return pair;
+  }
+};
+
+class TCPPeerTestHarness : public TestHarness<TCPPeerPair>
+{
+public:
+  TCPPeerTestHarness( std::string test_name, const TCPConfig& cfg )
+    : TCPPeerTestHarness( move( test_name ), cfg, cfg )
+  {}
+
+  TCPPeerTestHarness( std::string test_name, const TCPConfig& client_cfg, const TCPConfig& server_cfg )
+    : TestHarness( move( test_name ),
+                   "a connected client (mss=" + std::to_string( client_cfg.mss ) + ") and server (mss="
+                     + std::to_string( server_cfg.mss ) + "), delayed_ack_ms="
+                     + std::to_string( server_cfg.delayed_ack_ms ),
+                   TCPPeerPair::connected( client_cfg, server_cfg ) )
+  {}
+};
+
+/* actions */
+
+// The client sends full segments (of the negotiated MSS), which stay undelivered
+struct ClientSends : public Action<TCPPeerPair>
+{
+  size_t segments_;
+
+  explicit ClientSends( size_t segments ) : segments_( segments ) {}
+  std::string description() const override
+  {
+    return "client sends " + std::to_string( segments_ ) + " full segment(s)";
+  }
+  void execute( TCPPeerPair& p ) const override
+  {
+    p.client.outbound_writer().push( std::string( segments_ * p.client.sender().mss(), 'x' ) );
+    p.client.push( p.to_server() );
+  }
+};
+
+// Deliver one of the client's undelivered messages (by its position among them) to the server
+struct DeliverToServer : public Action<TCPPeerPair>
+{
+  size_t index_;
+
+  explicit DeliverToServer( size_t index ) : index_( index ) {}
+  std::string description() const override
+  {
+    return "deliver the client's message #" + std::to_string( index_ ) + " to the server";
+  }
+  void execute( TCPPeerPair& p ) const override { p.server.receive( p.from_client.at( index_ ), p.to_client() ); }
+};
+
+struct DeliverToClient : public Action<TCPPeerPair>
+{
+  std::string description() const override { return "deliver the server's messages to the client"; }
+  void execute( TCPPeerPair& p ) const override { p.deliver_to_client(); }
+};
+
+// The server's SYN-ACK reaches the client a second time (as if retransmitted)
+struct RedeliverSynAck : public Action<TCPPeerPair>
+{
+  std::string description() const override { return "deliver the server's SYN-ACK to the client again"; }
+  void execute( TCPPeerPair& p ) const override { p.client.receive( p.syn_ack, p.to_server() ); }
+};
+
+struct ServerTick : public Action<TCPPeerPair>
+{
+  uint64_t ms_;
+
+  explicit ServerTick( uint64_t ms ) : ms_( ms ) {}
+  std::string description() const override { return "server ticks " + std::to_string( ms_ ) + " ms"; }
+  void execute( TCPPeerPair& p ) const override { p.server.tick( ms_, p.to_client() ); }
+};
+
+struct ServerSends : public Action<TCPPeerPair>
+{
+  std::string data_;
+
+  explicit ServerSends( std::string data ) : data_( std::move( data ) ) {}
+  std::string description() const override { return "server sends \"" + Printer::prettify( data_ ) + "\""; }
+  void execute( TCPPeerPair& p ) const override
+  {
+    p.server.outbound_writer().push( data_ );
+    p.server.push( p.to_client() );
+  }
+};
+
+/* expectations */
+
+struct ClientMessages : public ExpectNumber<TCPPeerPair, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "messages sent by the client"; }
+  size_t value( TCPPeerPair& p ) const override { return p.from_client.size(); }
+};
+
+struct ServerMessages : public ExpectNumber<TCPPeerPair, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "messages sent by the server"; }
+  size_t value( TCPPeerPair& p ) const override { return p.from_server.size(); }
+};
+
+// The ackno on the server's last message covers this many bytes of the client's data (with the default ISN)
+struct LastAckCovers : public ExpectNumber<TCPPeerPair, std::optional<Wrap32>>
+{
+  explicit LastAckCovers( uint64_t bytes ) : ExpectNumber( Wrap32::wrap( 1 + bytes, TCPConfig {}.isn ) ) {}
+  std::string name() const override { return "ackno of the server's last message"; }
+  std::optional<Wrap32> value( TCPPeerPair& p ) const override
+  {
+    if ( p.from_server.empty() ) {
+      return {};
+    }
+    return p.from_server.back().receiver.ackno;
+  }
+};
+
+struct LastPayload : public Expectation<TCPPeerPair>
+{
+  std::string payload_;
+
+  explicit LastPayload( std::string payload ) : payload_( std::move( payload ) ) {}
+  std::string description() const override
+  {
+    return "server's last message carries \"" + Printer::prettify( payload_ ) + "\"";
+  }
+  void execute( TCPPeerPair& p ) const override
+  {
+    const std::string got = p.from_server.empty() ? "" : std::string { p.from_server.back().sender.payload };
+    if ( got != payload_ ) {
+      throw ExpectationViolation { "The server's last message should have carried \""
+                                   + Printer::prettify( payload_ ) + "\", but instead it carried \""
+                                   + Printer::prettify( got ) + "\"." };
+    }
+  }
+};
+
+struct ClientCongestionWindow : public ExpectNumber<TCPPeerPair, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "client's congestion window"; }
+  uint64_t value( TCPPeerPair& p ) const override { return p.client.sender().congestion_window(); }
+};
+
+struct ServerBytesBuffered : public ExpectNumber<TCPPeerPair, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "bytes buffered in the server's inbound stream"; }
+  uint64_t value( TCPPeerPair& p ) const override { return p.server.inbound_reader().bytes_buffered(); }
+};
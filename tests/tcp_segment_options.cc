@@ -0,0 +1,219 @@
+#include "checksum.hh"
+#include "common.hh"
+#include "parser.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t pseudo_checksum = 0x1234;
+
+TCPSegment roundtrip( TCPSegment segment )
+{
+  segment.compute_checksum( pseudo_checksum );
+  TCPSegment parsed;
+  if ( not parse( parsed, serialize( segment ), pseudo_checksum ) ) {
+    throw runtime_error( "serialized segment did not parse" );
+  }
+  return parsed;
+}
+
+// a segment (with only the ACK flag) with the given option bytes, which must fill whole 32-bit words
+vector<string> raw_segment( const string& options, const string& payload )
+{
+  string raw { "\x00\x01\x00\x02\x00\x00\x00\x07\x00\x00\x00\x64\x00\x10\x13\x88\x00\x00\x00\x00", 20 };
+  raw[12] = static_cast<char>( ( 5 + options.size() / 4 ) << 4 );
+  raw += options + payload;
+
+  InternetChecksum checksum { pseudo_checksum };
+  checksum.add( raw );
+  raw[16] = static_cast<char>( checksum.value() >> 8 );
+  raw[17] = static_cast<char>( checksum.value() & 0xff );
+  return { raw };
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      TCPSegment syn;
+      syn.message.sender = { .seqno = Wrap32 { 1000 }, .SYN = true, .SACK_permitted = true, .window_scale = 7 };
+      const TCPSegment parsed = roundtrip( syn );
+      expect( parsed.message.sender.SYN and parsed.message.sender.SACK_permitted, "SACK-permitted on SYN" );
+      expect( parsed.message.sender.window_scale == 7, "window scale on SYN" );
+    }
+
+    {
+      // window scale is a SYN-only option, and an unscaled window saturates the 16-bit field
+      TCPSegment ack;
+      ack.message.sender = { .seqno = Wrap32 { 1001 }, .window_scale = 7 };
+      ack.message.receiver.window_size = 100000;
+      const TCPSegment parsed = roundtrip( ack );
+      expect( not parsed.message.sender.window_scale.has_value(), "no window scale without SYN" );
+      expect( parsed.message.receiver.window_size == UINT16_MAX, "saturated window" );
+    }
+
+    {
+      // the IP adapter scales windows once both SYNs have offered a scale
+      TCPOverIPv4Adapter client;
+      TCPOverIPv4Adapter server;
+      TCPMessage syn;
+      syn.sender = { .seqno = Wrap32 { 0 }, .SYN = true, .window_scale = 4 };
+      syn.receiver.window_size = 1000000;
+      auto received = server.unwrap_tcp_in_ip( client.wrap_tcp_in_ip( syn ) );
+      expect( received.has_value() and received->receiver.window_size == UINT16_MAX, "SYN's window isn't scaled" );
+
+      TCPMessage syn_ack;
+      syn_ack.sender = { .seqno = Wrap32 { 0 }, .SYN = true, .window_scale = 2 };
+      syn_ack.receiver = { .ackno = Wrap32 { 1 }, .window_size = 50000 };
+      received = client.unwrap_tcp_in_ip( server.wrap_tcp_in_ip( syn_ack ) );
+      expect( received.has_value() and received->receiver.window_size == 50000, "SYN-ACK's window isn't scaled" );
+
+      TCPMessage ack;
+      ack.sender = { .seqno = Wrap32 { 1 } };
+      ack.receiver = { .ackno = Wrap32 { 1 }, .window_size = 1000000 };
+      received = server.unwrap_tcp_in_ip( client.wrap_tcp_in_ip( ack ) );
+      expect( received.has_value() and received->receiver.window_size == 1000000, "client's window scaled by 16" );
+
+      ack.receiver.window_size = 200003;
+      received = client.unwrap_tcp_in_ip( server.wrap_tcp_in_ip( ack ) );
+      expect( received.has_value() and received->receiver.window_size == 200000, "server's window scaled by 4" );
+    }
+
+    {
+      TCPSegment syn;
+      syn.message.sender = { .seqno = Wrap32 { 0 }, .SYN = true, .mss = 1460 };
+      const TCPSegment parsed = roundtrip( syn );
+      expect( parsed.message.sender.mss == 1460, "MSS on SYN" );
+    }
+
+    {
+      // a large message is split at the MSS the peer announced, with SYN on the first piece and FIN on the last
+      TCPOverIPv4Adapter client;
+      TCPOverIPv4Adapter server;
+      TCPMessage syn;
+      syn.sender = { .seqno = Wrap32 { 0 }, .SYN = true, .mss = 500 };
+      expect( client.unwrap_tcp_in_ip( server.wrap_tcp_in_ip( syn ) ).has_value(), "SYN with MSS" );
+
+      TCPMessage big;
+      big.sender = { .seqno = Wrap32 { 100 }, .SYN = true, .payload = string( 1200, 'x' ), .FIN = true };
+      const auto datagrams = client.wrap_tcp_in_ip_segments( big );
+      expect( datagrams.size() == 3, "number of pieces" );
+
+      vector<TCPMessage> pieces;
+      for ( const auto& dgram : datagrams ) {
+        auto received = server.unwrap_tcp_in_ip( dgram );
+        expect( received.has_value(), "piece parses" );
+        pieces.push_back( *received );
+      }
+      expect( pieces[0].sender.SYN and not pieces[1].sender.SYN and not pieces[2].sender.SYN,
+              "SYN on first piece" );
+      expect( not pieces[0].sender.FIN and not pieces[1].sender.FIN and pieces[2].sender.FIN, "FIN on last piece" );
+      expect( pieces[0].sender.seqno == Wrap32 { 100 } and pieces[1].sender.seqno == Wrap32 { 601 }
+                and pieces[2].sender.seqno == Wrap32 { 1101 },
+              "seqnos of pieces" );
+      expect( pieces[0].sender.payload.size() == 500 and pieces[2].sender.payload.size() == 200, "piece sizes" );
+    }
+
+    {
+      // a zero MSS is raised to the floor, both for splitting and for the peer's sender
+      TCPOverIPv4Adapter client;
+      TCPOverIPv4Adapter server;
+      TCPMessage syn;
+      syn.sender = { .seqno = Wrap32 { 0 }, .SYN = true, .mss = 0 };
+      expect( client.unwrap_tcp_in_ip( server.wrap_tcp_in_ip( syn ) ).has_value(), "SYN with zero MSS" );
+
+      TCPMessage big;
+      big.sender = { .seqno = Wrap32 { 100 }, .payload = string( 200, 'x' ) };
+      const auto datagrams = client.wrap_tcp_in_ip_segments( big );
+      expect( datagrams.size() == 3, "number of pieces at the MSS floor" );
+      const auto last = server.unwrap_tcp_in_ip( datagrams.back() );
+      expect( last.has_value() and last->sender.payload.size() == 200 - 2 * TCPConfig::MIN_MSS,
+              "last piece at the MSS floor" );
+
+      TCPPeer peer { TCPConfig {} };
+      peer.receive( syn, []( const TCPMessage& ) {} );
+      expect( peer.sender().mss() == TCPConfig::MIN_MSS, "peer's MSS raised to the floor" );
+    }
+
+    {
+      TCPSegment ack;
+      ack.message.sender = { .seqno = Wrap32 { 7 }, .payload = "hello" };
+      ack.message.receiver.ackno = Wrap32 { 100 };
+      ack.message.receiver.window_size = 5000;
+      for ( uint32_t i = 0; i < 5; ++i ) {
+        ack.message.receiver.sack_blocks.push_back( { Wrap32 { 200 + 100 * i }, Wrap32 { 250 + 100 * i } } );
+      }
+
+      // only the first four blocks fit
+      const TCPSegment parsed = roundtrip( ack );
+      const auto& blocks = parsed.message.receiver.sack_blocks;
+      expect( blocks.size() == TCPReceiverMessage::MAX_SACK_BLOCKS, "number of SACK blocks" );
+      for ( uint32_t i = 0; i < blocks.size(); ++i ) {
+        expect( blocks[i].left == Wrap32 { 200 + 100 * i } and blocks[i].right == Wrap32 { 250 + 100 * i },
+                "SACK block contents" );
+      }
+      expect( parsed.message.receiver.ackno == Wrap32 { 100 } and parsed.message.receiver.window_size == 5000,
+              "ackno and window alongside options" );
+      expect( parsed.message.sender.payload == "hello", "payload after options" );
+    }
+
+    {
+      TCPSegment ack;
+      ack.message.sender = { .seqno = Wrap32 { 7 }, .timestamp = 0x12345678 };
+      ack.message.receiver = { .ackno = Wrap32 { 100 }, .timestamp_echo = 0x9abcdef0 };
+      for ( uint32_t i = 0; i < 5; ++i ) {
+        ack.message.receiver.sack_blocks.push_back( { Wrap32 { 200 + 100 * i }, Wrap32 { 250 + 100 * i } } );
+      }
+
+      // the timestamp and its echo travel together, leaving room for three SACK blocks
+      const TCPSegment parsed = roundtrip( ack );
+      expect( parsed.message.sender.timestamp == 0x12345678, "timestamp" );
+      expect( parsed.message.receiver.timestamp_echo == 0x9abcdef0, "timestamp echo" );
+      expect( parsed.message.receiver.sack_blocks.size() == TCPReceiverMessage::MAX_SACK_BLOCKS_WITH_TIMESTAMP,
+              "number of SACK blocks alongside a timestamp" );
+      expect( parsed.header_length() <= 60, "options fit the header" );
+
+      // without the ACK flag, there's nothing to echo
+      TCPSegment syn;
+      syn.message.sender = { .seqno = Wrap32 { 0 }, .SYN = true, .SACK_permitted = true, .window_scale = 7,
+                             .mss = 1460, .timestamp = 1 };
+      const TCPSegment parsed_syn = roundtrip( syn );
+      expect( parsed_syn.message.sender.timestamp == 1, "timestamp on SYN" );
+      expect( not parsed_syn.message.receiver.timestamp_echo.has_value(), "no echo without ACK" );
+      expect( parsed_syn.message.sender.mss == 1460 and parsed_syn.message.sender.window_scale == 7,
+              "timestamp alongside the other SYN options" );
+    }
+
+    {
+      // unknown options are skipped...
+      TCPSegment parsed;
+      const string options { "\x08\x03\x01\x01\x04\x02\x00\x00", 8 };
+      expect( parse( parsed, { raw_segment( options, "xyz" ) }, pseudo_checksum ), "skip unknown option" );
+      expect( parsed.message.sender.SACK_permitted, "option after an unknown one" );
+      expect( parsed.message.sender.payload == "xyz", "payload after unknown option" );
+
+      // ... but an option running past the header is an error
+      expect( not parse( parsed, { raw_segment( string { "\x05\x0a\x00\x00", 4 }, "" ) }, pseudo_checksum ),
+              "truncated option" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#include "tcp_config.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+void speed_test( const size_t window_size, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t total_bytes, // NOLINT(bugprone-easily-swappable-parameters)
+                 const bool super_segments )
+{
+  const Wrap32 isn { 0 };
+  TCPSender sender { ByteStream { 2 * window_size }, isn, 1000 };
+  sender.set_mss( TCPConfig::MAX_PAYLOAD_SIZE, super_segments );
+
+  uint64_t bytes_sent = 0;
+  uint64_t messages_sent = 0;
+  const auto transmit = [&]( span<const TCPSenderMessage> batch ) {
+    for ( const auto& msg : batch ) {
+      bytes_sent += msg.payload.size();
+    }
+    messages_sent += batch.size();
+  };
+
+  sender.push_batch( transmit );
+  sender.receive( { .ackno = isn + 1, .window_size = static_cast<uint32_t>( window_size ) } );
+
+  // fill the window, then acknowledge all of it, until everything is sent
+  const string data( window_size, 'x' );
+  const auto start_time = steady_clock::now();
+  while ( bytes_sent < total_bytes ) {
+    Writer& writer = sender.writer();
+    writer.push( data.substr( 0, writer.available_capacity() ) );
+    sender.push_batch( transmit );
+    const Wrap32 ackno = isn + 1 + static_cast<uint32_t>( bytes_sent );
+    sender.receive( { .ackno = ackno, .window_size = static_cast<uint32_t>( window_size ) } );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( sender.sequence_numbers_in_flight() != 0 ) {
+    throw runtime_error( "TCPSender did not clear its outstanding segments" );
+  }
+
+  const auto seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const auto gigabits_per_second = 8.0 * static_cast<double>( bytes_sent ) / seconds / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const string name
+    = super_segments ? "super-segments" : to_string( TCPConfig::MAX_PAYLOAD_SIZE ) + "-byte segments";
+  cout << "TCPSender with " << name << " and a " << window_size << "-byte window sent " << messages_sent
+       << " messages at " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  debug_output << setw( 18 ) << name << " TCPSender throughput: " << fixed << setprecision( 2 )
+               << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "TCPSender did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 65535, 500000000, false );
+  speed_test( 65535, 500000000, true );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
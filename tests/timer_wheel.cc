@@ -0,0 +1,111 @@
+#include "random.hh"
+#include "timer_wheel_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// compare against a simple map of deadlines, with random arms, cancels and advances
+void random_test( const int rounds )
+{
+  TimerWheelTestHarness test { "random arms, cancels and advances (" + to_string( rounds ) + " rounds)" };
+
+  auto rd = get_random_engine();
+  map<uint64_t, uint64_t> deadlines; // tag -> deadline, for the timers not yet fired or cancelled
+  vector<uint64_t> cancellable;      // tags armed by the test (some since fired)
+  uint64_t now = 0;
+  uint64_t next_tag = 0;
+
+  for ( int round = 0; round < rounds; ++round ) {
+    const auto action = uniform_int_distribution<int> { 0, 9 }( rd );
+    if ( action < 5 ) {
+      const uint64_t scale = uint64_t { 1 } << uniform_int_distribution<int> { 0, 24 }( rd );
+      const uint64_t delay = uniform_int_distribution<uint64_t> { 1, scale }( rd );
+      test.execute( Arm { delay, next_tag } );
+      deadlines.emplace( next_tag, now + delay );
+      cancellable.push_back( next_tag );
+      ++next_tag;
+    } else if ( action < 7 and not cancellable.empty() ) {
+      const auto i = uniform_int_distribution<size_t> { 0, cancellable.size() - 1 }( rd );
+      test.execute( Cancel { cancellable[i] } );
+      deadlines.erase( cancellable[i] );
+      cancellable[i] = cancellable.back();
+      cancellable.pop_back();
+    } else {
+      const uint64_t scale = uint64_t { 1 } << uniform_int_distribution<int> { 0, 20 }( rd );
+      const uint64_t ms = uniform_int_distribution<uint64_t> { 0, scale }( rd );
+      now += ms;
+      test.execute( Advance { ms } );
+
+      vector<uint64_t> due;
+      erase_if( deadlines, [&]( const auto& entry ) {
+        if ( entry.second <= now ) {
+          due.push_back( entry.first );
+          return true;
+        }
+        return false;
+      } );
+      test.execute( FiredInAnyOrder { due } );
+      test.execute( ArmedCount { deadlines.size() } );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    {
+      TimerWheelTestHarness test { "timers fire once their delay has passed, in order, across levels" };
+      test.execute( Arm { 5, 5 } );
+      test.execute( Arm { 100, 100 } );
+      test.execute( Arm { 5000, 5000 } );
+      test.execute( Arm { 300000, 300000 } );
+      test.execute( ArmedCount { 4 } );
+
+      test.execute( Advance { 4 } );
+      test.execute( Fired { {} } );
+      test.execute( Advance { 1 } );
+      test.execute( Fired { { 5 } } );
+      test.execute( Advance { 99 } );
+      test.execute( Fired { { 100 } } ); // after cascading a level
+      test.execute( Advance { 1000000 } );
+      test.execute( Fired { { 5000, 300000 } } );
+      test.execute( ArmedCount { 0 } );
+      test.execute( NowMs { 1000104 } );
+    }
+
+    {
+      TimerWheelTestHarness test { "cancelled timers don't fire, and stale handles don't cancel newer timers" };
+      test.execute( Arm { 10, 1 } );
+      test.execute( Cancel { 1 } );
+      test.execute( IsArmed { 1, false } );
+      test.execute( Arm { 10, 2 } );
+      test.execute( Cancel { 1 } );
+      test.execute( IsArmed { 2, true } );
+      test.execute( Advance { 10 } );
+      test.execute( Fired { { 2 } } );
+      test.execute( IsArmed { 2, false } );
+    }
+
+    {
+      TimerWheelTestHarness test { "a callback may re-arm" };
+      test.execute( Arm { 1, 3 } );
+      test.execute( ArmOnFire { 3, 2, 4 } );
+      test.execute( Advance { 5 } );
+      test.execute( Fired { { 3, 4 } } );
+      test.execute( ArmedCount { 0 } );
+    }
+
+    random_test( 20000 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
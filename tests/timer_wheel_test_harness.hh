@@ -0,0 +1,169 @@
+#pragma once
+
+#include "common.hh"
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A TimerWheel, with the handles of the timers the test armed (by tag) and the tags fired by the last advance
+struct RecordingTimerWheel
+{
+  TimerWheel wheel {};
+  std::map<uint64_t, TimerWheel::Handle> handles {};
+  std::map<uint64_t, std::pair<uint64_t, uint64_t>> rearm_on_fire {}; // tag -> ( delay, tag to arm )
+  std::vector<uint64_t> fired {};
+
+  void arm( uint64_t delay_ms, uint64_t tag ) { handles.insert_or_assign( tag, wheel.arm( delay_ms, tag ) ); }
+};
+
+class TimerWheelTestHarness : public TestHarness<RecordingTimerWheel>
+{
+public:
+  explicit TimerWheelTestHarness( std::string test_name )
+    : TestHarness( move( test_name ), "no timers", RecordingTimerWheel {} )
+  {}
+};
+
+inline std::string tags_to_string( const std::vector<uint64_t>& tags )
+{
+  std::string ret = "{";
+  for ( size_t i = 0; i < tags.size(); ++i ) {
+    ret += ( i ? ", " : " " ) + std::to_string( tags[i] );
+  }
+  return ret + " }";
+}
+
+/* actions */
+
+struct Arm : public Action<RecordingTimerWheel>
+{
+  uint64_t delay_ms_;
+  uint64_t tag_;
+
+  Arm( uint64_t delay_ms, uint64_t tag ) : delay_ms_( delay_ms ), tag_( tag ) {}
+  std::string description() const override
+  {
+    return "arm timer " + std::to_string( tag_ ) + " for " + std::to_string( delay_ms_ ) + " ms";
+  }
+  void execute( RecordingTimerWheel& tw ) const override { tw.arm( delay_ms_, tag_ ); }
+};
+
+// When timer `tag` fires, its callback arms another timer
+struct ArmOnFire : public Action<RecordingTimerWheel>
+{
+  uint64_t tag_;
+  uint64_t delay_ms_;
+  uint64_t new_tag_;
+
+  ArmOnFire( uint64_t tag, uint64_t delay_ms, uint64_t new_tag )
+    : tag_( tag ), delay_ms_( delay_ms ), new_tag_( new_tag )
+  {}
+  std::string description() const override
+  {
+    return "have timer " + std::to_string( tag_ ) + " arm timer " + std::to_string( new_tag_ ) + " for "
+           + std::to_string( delay_ms_ ) + " ms when it fires";
+  }
+  void execute( RecordingTimerWheel& tw ) const override
+  {
+    tw.rearm_on_fire.insert_or_assign( tag_, std::pair { delay_ms_, new_tag_ } );
+  }
+};
+
+// Cancels through a copy of the handle, so the recorded one goes stale (and cancelling it again must be harmless)
+struct Cancel : public Action<RecordingTimerWheel>
+{
+  uint64_t tag_;
+
+  explicit Cancel( uint64_t tag ) : tag_( tag ) {}
+  std::string description() const override { return "cancel timer " + std::to_string( tag_ ); }
+  void execute( RecordingTimerWheel& tw ) const override
+  {
+    TimerWheel::Handle handle = tw.handles.at( tag_ );
+    tw.wheel.cancel( handle );
+  }
+};
+
+struct Advance : public Action<RecordingTimerWheel>
+{
+  uint64_t ms_;
+
+  explicit Advance( uint64_t ms ) : ms_( ms ) {}
+  std::string description() const override { return "advance " + std::to_string( ms_ ) + " ms"; }
+  void execute( RecordingTimerWheel& tw ) const override
+  {
+    tw.fired.clear();
+    tw.wheel.advance( ms_, [&]( uint64_t tag ) {
+      tw.fired.push_back( tag );
+      if ( const auto it = tw.rearm_on_fire.find( tag ); it != tw.rearm_on_fire.end() ) {
+        tw.arm( it->second.first, it->second.second );
+      }
+    } );
+  }
+};
+
+/* expectations */
+
+// The tags fired by the last advance, in order
+struct Fired : public Expectation<RecordingTimerWheel>
+{
+  std::vector<uint64_t> tags_;
+
+  explicit Fired( std::vector<uint64_t> tags ) : tags_( std::move( tags ) ) {}
+  std::string description() const override { return "fired " + tags_to_string( tags_ ); }
+  void execute( RecordingTimerWheel& tw ) const override
+  {
+    if ( tw.fired != tags_ ) {
+      throw ExpectationViolation { "The timer wheel should have fired " + tags_to_string( tags_ )
+                                   + ", but instead it fired " + tags_to_string( tw.fired ) + "." };
+    }
+  }
+};
+
+// The tags fired by the last advance, in any order (timers with the same deadline may fire in either order)
+struct FiredInAnyOrder : public Expectation<RecordingTimerWheel>
+{
+  std::vector<uint64_t> tags_;
+
+  explicit FiredInAnyOrder( std::vector<uint64_t> tags ) : tags_( std::move( tags ) )
+  {
+    std::ranges::sort( tags_ );
+  }
+  std::string description() const override { return "fired " + tags_to_string( tags_ ) + " in any order"; }
+  void execute( RecordingTimerWheel& tw ) const override
+  {
+    auto fired = tw.fired;
+    std::ranges::sort( fired );
+    if ( fired != tags_ ) {
+      throw ExpectationViolation { "The timer wheel should have fired " + tags_to_string( tags_ )
+                                   + ", but instead it fired " + tags_to_string( fired ) + "." };
+    }
+  }
+};
+
+struct IsArmed : public ExpectBool<RecordingTimerWheel>
+{
+  uint64_t tag_;
+
+  IsArmed( uint64_t tag, bool armed ) : ExpectBool( armed ), tag_( tag ) {}
+  std::string name() const override { return "armed( timer " + std::to_string( tag_ ) + " )"; }
+  bool value( RecordingTimerWheel& tw ) const override { return tw.wheel.armed( tw.handles.at( tag_ ) ); }
+};
+
+struct ArmedCount : public ExpectNumber<RecordingTimerWheel, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "size"; }
+  size_t value( RecordingTimerWheel& tw ) const override { return tw.wheel.size(); }
+};
+
+struct NowMs : public ExpectNumber<RecordingTimerWheel, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "now_ms"; }
+  uint64_t value( RecordingTimerWheel& tw ) const override { return tw.wheel.now_ms(); }
+};
@@ -0,0 +1,116 @@
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// unwrap_batch takes a different route to the answer than unwrap, so compare them where it matters:
+// checkpoints near zero and near multiples of 2^31, and a count that leaves a partial block
+void check_batch_matches_unwrap( const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  const vector<uint64_t> checkpoints { 0,           1,           1UL << 20,         ( 1UL << 31 ) - 1,
+                                       1UL << 31,   1UL << 32,   ( 3UL << 31 ) + 7, UINT64_MAX - ( 1UL << 20 ) };
+  vector<Wrap32> values( 1001, Wrap32 { 0 } );
+  vector<uint64_t> batched( values.size() );
+
+  for ( const uint64_t checkpoint : checkpoints ) {
+    const Wrap32 zero_point { uniform_int_distribution<uint32_t> {}( rd ) };
+    for ( auto& value : values ) {
+      value = Wrap32 { uniform_int_distribution<uint32_t> {}( rd ) };
+    }
+    Wrap32::unwrap_batch( values, zero_point, checkpoint, batched );
+    for ( size_t i = 0; i < values.size(); ++i ) {
+      if ( batched[i] != values[i].unwrap( zero_point, checkpoint ) ) {
+        throw runtime_error( "Wrap32::unwrap_batch disagrees with Wrap32::unwrap (checkpoint "
+                             + to_string( checkpoint ) + ")" );
+      }
+    }
+  }
+}
+
+void speed_test( const size_t num_values, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t num_rounds, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed )
+{
+  // Generate sequence numbers scattered within a window on either side of the checkpoint
+  default_random_engine rd { random_seed };
+  const Wrap32 zero_point { uniform_int_distribution<uint32_t> {}( rd ) };
+  const uint64_t checkpoint = ( 5UL << 32 ) + uniform_int_distribution<uint32_t> {}( rd );
+  uniform_int_distribution<uint64_t> offset { checkpoint - ( 1UL << 20 ), checkpoint + ( 1UL << 20 ) };
+
+  vector<uint64_t> expected;
+  vector<Wrap32> values;
+  for ( size_t i = 0; i < num_values; ++i ) {
+    expected.push_back( offset( rd ) );
+    values.push_back( Wrap32::wrap( expected.back(), zero_point ) );
+  }
+
+  vector<uint64_t> one_at_a_time( num_values );
+  vector<uint64_t> batched( num_values );
+
+  const auto start_time = steady_clock::now();
+  for ( size_t round = 0; round < num_rounds; ++round ) {
+    for ( size_t i = 0; i < num_values; ++i ) {
+      one_at_a_time[i] = values[i].unwrap( zero_point, checkpoint + round );
+    }
+  }
+  const auto batch_start_time = steady_clock::now();
+  for ( size_t round = 0; round < num_rounds; ++round ) {
+    Wrap32::unwrap_batch( values, zero_point, checkpoint + round, batched );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( one_at_a_time != expected or batched != expected ) {
+    throw runtime_error( "Mismatch between wrapped and unwrapped sequence numbers" );
+  }
+
+  const auto total = static_cast<double>( num_values * num_rounds );
+  const auto unwraps_per_second = total / duration_cast<duration<double>>( batch_start_time - start_time ).count();
+  const auto batched_per_second = total / duration_cast<duration<double>>( stop_time - batch_start_time ).count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Wrap32::unwrap reached " << fixed << setprecision( 2 ) << unwraps_per_second / 1e6
+       << " M/s; unwrap_batch reached " << batched_per_second / 1e6 << " M/s ("
+       << batched_per_second / unwraps_per_second << "x).\n";
+
+  debug_output << "           Wrap32::unwrap throughput: " << fixed << setprecision( 2 )
+               << unwraps_per_second / 1e6 << " M/s\n";
+  debug_output << "     Wrap32::unwrap_batch throughput: " << fixed << setprecision( 2 )
+               << batched_per_second / 1e6 << " M/s (" << batched_per_second / unwraps_per_second
+               << "x)\n";
+
+  if ( unwraps_per_second < 1e6 or batched_per_second < 1e6 ) {
+    throw runtime_error( "Wrap32::unwrap did not meet minimum speed of 1M unwraps/s." );
+  }
+}
+
+void program_body()
+{
+  check_batch_matches_unwrap( 1371 );
+  speed_test( 4096, 10000, 1370 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
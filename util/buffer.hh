@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ * A read-only, reference-counted string (or a slice of one). Copying a Buffer, or taking a substr() of it,
+ * shares the underlying bytes instead of copying them; they are freed when the last Buffer using them is.
+ */
+class Buffer
+{
+  std::shared_ptr<std::string> storage_ {}; // never modified while shared
+  size_t offset_ {};
+  size_t size_ {};
+
+public:
+  Buffer() = default;
+
+  // Take ownership of a string
+  Buffer( std::string str ) // NOLINT(*-explicit-*)
+    : storage_( str.empty() ? nullptr : std::make_shared<std::string>( std::move( str ) ) )
+    , size_( storage_ ? storage_->size() : 0 )
+  {}
+  Buffer( const char* str ) : Buffer( std::string { str } ) {} // NOLINT(*-explicit-*)
+
+  std::string_view view() const
+  {
+    return storage_ ? std::string_view { *storage_ }.substr( offset_, size_ ) : std::string_view {};
+  }
+  operator std::string_view() const { return view(); } // NOLINT(*-explicit-*)
+  explicit operator std::string() const { return std::string { view() }; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // A slice of the buffer (sharing its bytes)
+  Buffer substr( size_t pos, size_t len = std::string::npos ) const
+  {
+    Buffer ret { *this };
+    ret.offset_ += std::min( pos, size_ );
+    ret.size_ = std::min( len, size_ - std::min( pos, size_ ) );
+    return ret;
+  }
+
+  // The contents as a string: without a copy, if this is the only user of the whole underlying string
+  std::string release() &&
+  {
+    std::string ret;
+    if ( storage_.use_count() == 1 and offset_ == 0 and size_ == storage_->size() ) {
+      ret = std::move( *storage_ );
+    } else {
+      ret = view();
+    }
+    *this = {};
+    return ret;
+  }
+
+  bool operator==( std::string_view other ) const { return view() == other; }
+};
@@ -0,0 +1,36 @@
+#include "eventfd.hh"
+#include "exception.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+EventFD::EventFD() : FileDescriptor( ::CheckSystemCall( "eventfd", eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) ) {}
+
+// N.B. notify() is usually called from a different thread than the one polling the eventfd,
+// so it writes directly rather than through FileDescriptor::write (which updates the shared write count).
+void EventFD::notify()
+{
+  const uint64_t one = 1;
+  if ( ::write( fd_num(), &one, sizeof( one ) ) < 0 and errno != EAGAIN ) {
+    throw unix_error { "write" };
+  }
+}
+
+uint64_t EventFD::clear()
+{
+  string counter( sizeof( uint64_t ), '\0' );
+  read( counter );
+  if ( counter.size() != sizeof( uint64_t ) ) {
+    return 0;
+  }
+
+  uint64_t count = 0;
+  memcpy( &count, counter.data(), sizeof( count ) );
+  return count;
+}
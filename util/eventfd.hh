@@ -0,0 +1,20 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <cstdint>
+
+//! A non-blocking FileDescriptor to a Linux [eventfd](\ref man2::eventfd), used to wake up a thread polling it
+class EventFD : public FileDescriptor
+{
+public:
+  //! Create a new eventfd that is not yet readable
+  EventFD();
+
+  //! Make the eventfd readable (wakes up any thread polling it for Direction::In)
+  void notify();
+
+  //! Consume any pending notifications so that the eventfd is no longer readable
+  //! \returns the number of notifications consumed
+  uint64_t clear();
+};
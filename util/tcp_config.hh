@@ -1,6 +1,7 @@
 #pragma once
 
 #include "address.hh"
+#include "congestion_controller.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -11,15 +12,47 @@
 class TCPConfig
 {
 public:
-  static constexpr size_t DEFAULT_CAPACITY = 64000; //!< Default capacity
-  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
-  static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
-  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
-
-  uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
-  size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
-  size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
-  Wrap32 isn { 137 };                      //!< Default initial sequence number
+  static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
+  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
+  static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
+  static constexpr uint64_t MIN_RTO_MS = 200;        //!< Lowest re-transmit timeout measured RTTs can lead to
+  static constexpr uint64_t MAX_RTO_MS = 60000;      //!< Highest re-transmit timeout (after backoff)
+  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+  static constexpr unsigned DUPLICATE_ACKS = 3;      //!< Duplicate acknowledgments that trigger fast retransmit
+  static constexpr uint64_t IDLE_SHRINK_MS = 10000;  //!< Release buffer memory after this long without receipt
+  static constexpr uint8_t MAX_WINDOW_SCALE = 14;    //!< Largest window scale shift (RFC 7323)
+  static constexpr size_t MAX_SUPER_SEGMENT = 65536; //!< Largest message in super-segment mode
+  static constexpr uint16_t DELAYED_ACK_DFLT = 40;   //!< Default wait for a second segment to acknowledge at once
+  static constexpr uint16_t MIN_MSS = 88;            //!< Smallest MSS taken from a peer's SYN (as Linux's floor)
+
+  uint16_t rt_timeout = TIMEOUT_DFLT;         //!< Initial value of the retransmission timeout, in milliseconds
+  size_t recv_capacity = DEFAULT_CAPACITY;    //!< Receive capacity, in bytes
+  size_t send_capacity = DEFAULT_CAPACITY;    //!< Sender capacity, in bytes
+  Wrap32 isn { 137 };                         //!< Default initial sequence number
+  uint16_t mss = MAX_PAYLOAD_SIZE;            //!< Largest payload to send, or (announced in the SYN) to accept
+  uint16_t delayed_ack_ms = DELAYED_ACK_DFLT; //!< Longest an in-order segment's acknowledgment waits (0: never)
+
+  //! Have the sender emit messages of up to MAX_SUPER_SEGMENT bytes, for the IP adapter to split into segments
+  bool super_segments = false;
+
+  //! Hold back a short segment while earlier data is unacknowledged (Nagle's algorithm), to coalesce small writes
+  bool nagle = true;
+
+  //! Offer the timestamp option (RFC 7323), for RTT measurement and protection against wrapped sequence numbers
+  bool timestamps = true;
+
+  //! Sender's congestion control algorithm
+  CongestionControl congestion_control = CongestionControl::NewReno;
+
+  //! Window scale shift to offer: the smallest that lets the advertised window cover `recv_capacity`
+  uint8_t window_scale() const
+  {
+    uint8_t shift = 0;
+    while ( shift < MAX_WINDOW_SCALE and ( recv_capacity >> shift ) > UINT16_MAX ) {
+      ++shift;
+    }
+    return shift;
+  }
 };
 
 //! Config for classes derived from FdAdapter
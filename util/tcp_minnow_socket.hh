@@ -1,9 +1,11 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "eventfd.hh"
 #include "eventloop.hh"
 #include "file_descriptor.hh"
 #include "socket.hh"
+#include "spsc_byte_stream.hh"
 #include "tcp_config.hh"
 #include "tcp_peer.hh"
 #include "tuntap_adapter.hh"
@@ -33,6 +35,38 @@ public:
   //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
   void listen_and_accept( const TCPConfig& c_tcp, const FdAdapterConfig& c_ad );
 
+  //! Exchange application bytes with the TCPPeer thread through lock-free in-process streams
+  //! instead of the socket pair; must be called before connect() or listen_and_accept()
+  void use_in_process_streams( uint64_t capacity = TCPConfig::DEFAULT_CAPACITY );
+
+  //! \name
+  //! In-process mode: the owner pushes to the outbound stream and pops from the inbound stream,
+  //! polling their data_event() and space_event() descriptors to wait
+
+  //!@{
+  SPSCByteStream& outbound_stream() { return _outbound_stream.value(); }
+  SPSCByteStream& inbound_stream() { return _inbound_stream.value(); }
+  //!@}
+
+  //! \name
+  //! While corked, only full segments of the outbound bytes go out (see TCPPeer::cork); the TCPPeer thread
+  //! applies a cork() before taking in any bytes written after it
+
+  //!@{
+  void cork();
+  void uncork();
+  //!@}
+
+  //! \name
+  //! Reads and writes go to the socket pair, which is unused in in-process mode, so there they throw
+
+  //!@{
+  template<typename BufferT>
+  void read( BufferT& buffer );
+  template<typename BufferT>
+  size_t write( const BufferT& buffer );
+  //!@}
+
   //! When a connected socket is destructed, it will send a RST
   ~TCPMinnowSocket();
 
@@ -66,9 +100,25 @@ private:
   //! Stream socket for reads and writes between owner and TCP thread
   LocalStreamSocket _thread_data;
 
+  //! In-process replacements for `_thread_data` (owner to TCP thread, and TCP thread to owner)
+  std::optional<SPSCByteStream> _outbound_stream {};
+  std::optional<SPSCByteStream> _inbound_stream {};
+
+  //! Corking the owner asked for last, and the eventfd that tells the TCPPeer thread to apply it
+  std::atomic_bool _corked { false };
+  EventFD _cork_event {};
+
+  bool _tcp_corked { false }; //!< Has the TCPPeer thread corked the TCPPeer?
+
   //! Set up the TCPPeer and the event loop
   void _initialize_TCP( const TCPConfig& config );
 
+  //! Cork or uncork the TCPPeer to match what the owner asked for last
+  void _apply_cork();
+
+  //! Set up the event loop rules that move bytes through the in-process streams
+  void _initialize_in_process_rules();
+
   //! TCP state machine
   std::optional<TCPPeer> _tcp {};
 
@@ -79,6 +79,9 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
   // 3) Incoming bytes reassembled by the Reassembler
   //    (needs to be read from the inbound_stream and written
   //    to the local stream socket back to the application)
+  //
+  // 4) The owner corked or uncorked the socket (needs to be
+  //    applied to the TCPPeer)
 
   // rule 1: read from filtered packet stream and dump into TCPConnection
   _eventloop.add_rule(
@@ -91,7 +94,8 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       }
 
       // debugging output:
-      if ( _thread_data.eof() and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
+      const bool owner_finished = _outbound_stream ? _outbound_stream->is_finished() : _thread_data.eof();
+      if ( owner_finished and _tcp.value().sender().sequence_numbers_in_flight() == 0 and not _fully_acked ) {
         std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
                   << " has been fully acknowledged.\n";
         _fully_acked = true;
@@ -99,12 +103,32 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     },
     [&] { return _tcp->active(); } );
 
+  // rule 4: cork or uncork the TCPPeer
+  _eventloop.add_rule(
+    "cork or uncork TCPPeer",
+    _cork_event,
+    Direction::In,
+    [&] {
+      _cork_event.clear();
+      _apply_cork();
+    },
+    [&] { return _tcp->active(); } );
+
+  // rules 2 and 3 go through the in-process streams instead, if the owner asked for them
+  if ( _outbound_stream ) {
+    _initialize_in_process_rules();
+    return;
+  }
+
   // rule 2: read from pipe into outbound buffer
   _eventloop.add_rule(
     "push bytes to TCPPeer",
     _thread_data,
     Direction::In,
     [&] {
+      // (rule 4 may not have run yet for a cork() made before these bytes were written)
+      _apply_cork();
+
       std::string data;
       data.resize( _tcp->outbound_writer().available_capacity() );
       _thread_data.read( data );
@@ -147,8 +171,7 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       // the pipe, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
       if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
+        const auto bytes_written = _thread_data.write( inbound.peek_iov( inbound.bytes_buffered() ) );
         inbound.pop( bytes_written );
       }
 
@@ -173,6 +196,123 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     } );
 }
 
+// N.B. The streams only write their eventfds on a transition (empty to non-empty, full to not full), and
+// this thread only clears one after finding nothing to do, so an event stays readable while there is work
+// left (e.g. bytes in the outbound stream while the outbound buffer is full); each rule's interest decides
+// whether that work is worth polling for.
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_initialize_in_process_rules()
+{
+  // rule 2: move bytes from the owner's outbound stream into the outbound buffer
+  _eventloop.add_rule(
+    "push bytes to TCPPeer",
+    _outbound_stream->data_event(),
+    Direction::In,
+    [&] {
+      SPSCByteStream& outbound = _outbound_stream.value();
+      Writer& writer = _tcp->outbound_writer();
+      _apply_cork(); // (as in the socket pair's rule 2)
+
+      // N.B. The EventLoop requires that a rule still interested after its callback has read its eventfd,
+      // so stop only once the stream is drained (and its event cleared) or the outbound buffer stays full.
+      while ( not outbound.is_finished() and not outbound.has_error() ) {
+        if ( writer.available_capacity() == 0 ) {
+          _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
+          if ( writer.available_capacity() == 0 ) {
+            break;
+          }
+          continue;
+        }
+        if ( outbound.bytes_buffered() == 0 ) {
+          if ( outbound.prepare_wait_for_data() ) {
+            break;
+          }
+          continue;
+        }
+        const auto piece = outbound.peek_both().first.substr( 0, writer.available_capacity() );
+        writer.push_view( piece );
+        outbound.pop( piece.size() );
+      }
+
+      if ( outbound.has_error() ) {
+        writer.set_error();
+      } else if ( outbound.is_finished() ) {
+        writer.close();
+        _outbound_shutdown = true;
+
+        // debugging output:
+        std::cerr << "DEBUG: minnow outbound stream to " << _datagram_adapter.config().destination.to_string()
+                  << " finished (" << _tcp.value().sender().sequence_numbers_in_flight() << " seqno"
+                  << ( _tcp.value().sender().sequence_numbers_in_flight() == 1 ? "" : "s" )
+                  << " still in flight).\n";
+      }
+
+      _tcp->push( [&]( auto x ) { _datagram_adapter.write( x ); } );
+    },
+    [&] {
+      return ( _tcp->active() ) and ( not _outbound_shutdown )
+             and ( _tcp->outbound_writer().available_capacity() > 0 );
+    } );
+
+  // rule 3: move bytes from the inbound buffer into the owner's inbound stream
+  _eventloop.add_rule(
+    "read bytes from inbound stream",
+    _inbound_stream->space_event(),
+    Direction::In,
+    [&] {
+      SPSCByteStream& stream = _inbound_stream.value();
+      Reader& inbound = _tcp->inbound_reader();
+
+      while ( inbound.bytes_buffered() and not stream.has_error() ) {
+        if ( stream.available_capacity() == 0 ) {
+          if ( stream.prepare_wait_for_space() ) {
+            break;
+          }
+          continue;
+        }
+        inbound.pop( stream.push( inbound.peek() ) );
+      }
+
+      // the owner gave up on the inbound stream, so the connection can't deliver the rest
+      if ( stream.has_error() ) {
+        inbound.set_error();
+      }
+
+      if ( inbound.is_finished() or inbound.has_error() ) {
+        if ( inbound.has_error() ) {
+          stream.set_error();
+        }
+        stream.close();
+        _inbound_shutdown = true;
+
+        // debugging output:
+        std::cerr << "DEBUG: minnow inbound stream from " << _datagram_adapter.config().destination.to_string()
+                  << " finished " << ( inbound.has_error() ? "uncleanly.\n" : "cleanly.\n" );
+      }
+    },
+    [&] {
+      return ( not _inbound_shutdown )
+             and ( _tcp->inbound_reader().bytes_buffered() or _tcp->inbound_reader().is_finished()
+                   or _tcp->inbound_reader().has_error() );
+    } );
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::_apply_cork()
+{
+  const bool corked = _corked.load();
+  if ( corked == _tcp_corked ) {
+    return;
+  }
+
+  _tcp_corked = corked;
+  if ( corked ) {
+    _tcp->cork();
+  } else {
+    _tcp->uncork( [&]( auto x ) { _datagram_adapter.write( x ); } );
+  }
+}
+
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
 //! \param[in] type is the type of AF_UNIX sockets to create (e.g., SOCK_SEQPACKET)
 //! \returns a std::pair of connected sockets
@@ -206,10 +346,59 @@ TCPMinnowSocket<AdaptT>::~TCPMinnowSocket()
   }
 }
 
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::use_in_process_streams( uint64_t capacity )
+{
+  if ( _tcp ) {
+    throw std::runtime_error( "use_in_process_streams() with TCPConnection already initialized" );
+  }
+
+  _outbound_stream.emplace( capacity );
+  _inbound_stream.emplace( capacity );
+}
+
+// N.B. These run on the owner thread, so they only record the request and wake the TCPPeer thread.
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::cork()
+{
+  _corked.store( true );
+  _cork_event.notify();
+}
+
+template<TCPDatagramAdapter AdaptT>
+void TCPMinnowSocket<AdaptT>::uncork()
+{
+  _corked.store( false );
+  _cork_event.notify();
+}
+
+template<TCPDatagramAdapter AdaptT>
+template<typename BufferT>
+void TCPMinnowSocket<AdaptT>::read( BufferT& buffer )
+{
+  if ( _inbound_stream ) {
+    throw std::runtime_error( "read() in in-process mode (pop from inbound_stream() instead)" );
+  }
+  LocalStreamSocket::read( buffer );
+}
+
+template<TCPDatagramAdapter AdaptT>
+template<typename BufferT>
+size_t TCPMinnowSocket<AdaptT>::write( const BufferT& buffer )
+{
+  if ( _outbound_stream ) {
+    throw std::runtime_error( "write() in in-process mode (push to outbound_stream() instead)" );
+  }
+  return LocalStreamSocket::write( buffer );
+}
+
 template<TCPDatagramAdapter AdaptT>
 void TCPMinnowSocket<AdaptT>::wait_until_closed()
 {
   shutdown( SHUT_RDWR );
+  if ( _outbound_stream ) {
+    _outbound_stream->close();
+  }
   if ( _tcp_thread.joinable() ) {
     std::cerr << "DEBUG: minnow waiting for clean shutdown... ";
     _tcp_thread.join();
@@ -282,9 +471,15 @@ void TCPMinnowSocket<AdaptT>::_tcp_main()
     }
     _tcp_loop( [] { return true; } );
     shutdown( SHUT_RDWR );
+    const bool any_errors = _tcp->inbound_reader().has_error() or _tcp->outbound_writer().has_error();
+    if ( _inbound_stream ) {
+      if ( any_errors ) {
+        _inbound_stream->set_error();
+      }
+      _inbound_stream->close();
+    }
     if ( not _tcp.value().active() ) {
-      std::cerr << "DEBUG: minnow TCP connection finished "
-                << ( _tcp->inbound_reader().has_error() ? "uncleanly.\n" : "cleanly.\n" );
+      std::cerr << "DEBUG: minnow TCP connection finished " << ( any_errors ? "uncleanly.\n" : "cleanly.\n" );
     }
     _tcp.reset();
   } catch ( const std::exception& e ) {
@@ -3,11 +3,15 @@
 #include "ipv4_datagram.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
+#include "tcp_config.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <stdexcept>
+#include <string_view>
 #include <unistd.h>
 #include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -69,7 +73,22 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( const InternetDatagra
     return {};
   }
 
-  return tcp_seg.message;
+  // learn the peer's window scale from its SYN, and apply it to the windows advertised afterwards
+  TCPMessage& msg = tcp_seg.message;
+  if ( msg.sender.SYN ) {
+    if ( msg.sender.window_scale.has_value() ) {
+      remote_window_scale_ = min( *msg.sender.window_scale, TCPConfig::MAX_WINDOW_SCALE );
+    }
+    // (N.B. a zero or tiny MSS would leave nothing, or almost nothing, to put in each segment)
+    remote_mss_ = msg.sender.mss;
+    if ( remote_mss_.has_value() ) {
+      remote_mss_ = max( *remote_mss_, TCPConfig::MIN_MSS );
+    }
+  } else if ( local_window_scale_.has_value() and remote_window_scale_.has_value() ) {
+    msg.receiver.window_size <<= *remote_window_scale_;
+  }
+
+  return msg;
 }
 
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
@@ -77,6 +96,14 @@ optional<TCPMessage> TCPOverIPv4Adapter::unwrap_tcp_in_ip( const InternetDatagra
 InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
 {
   TCPSegment seg { .message = msg };
+
+  // scale the window we advertise (except in a SYN) down to fit the header field
+  if ( msg.sender.SYN ) {
+    local_window_scale_ = msg.sender.window_scale;
+  } else if ( local_window_scale_.has_value() and remote_window_scale_.has_value() ) {
+    seg.message.receiver.window_size >>= *local_window_scale_;
+  }
+
   // set the port numbers in the TCP segment
   seg.udinfo.src_port = config().source.port();
   seg.udinfo.dst_port = config().destination.port();
@@ -85,7 +112,7 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
   InternetDatagram ip_dgram;
   ip_dgram.header.src = config().source.ipv4_numeric();
   ip_dgram.header.dst = config().destination.ipv4_numeric();
-  ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ + seg.message.sender.payload.size();
+  ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() + seg.message.sender.payload.size();
 
   // set payload, calculating TCP checksum using information from IP header
   seg.compute_checksum( ip_dgram.header.pseudo_checksum() );
@@ -94,3 +121,31 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip( const TCPMessage& msg )
 
   return ip_dgram;
 }
+
+//! \details The SYN (and its options) goes with the first segment and the FIN with the last, and each
+//! segment's seqno follows on from the previous one's payload. The acknowledgment is repeated in each.
+vector<InternetDatagram> TCPOverIPv4Adapter::wrap_tcp_in_ip_segments( const TCPMessage& msg )
+{
+  const size_t mss = remote_mss_.value_or( TCPConfig::MAX_PAYLOAD_SIZE );
+  if ( msg.sender.payload.size() <= mss ) {
+    return { wrap_tcp_in_ip( msg ) };
+  }
+
+  vector<InternetDatagram> datagrams;
+  const Buffer& payload = msg.sender.payload;
+  for ( size_t offset = 0; offset < payload.size(); offset += mss ) {
+    // copying the message shares its payload, and each piece takes a slice of it
+    TCPMessage piece { msg };
+    piece.sender.payload = payload.substr( offset, mss );
+    piece.sender.FIN = msg.sender.FIN and offset + mss >= payload.size();
+    if ( offset > 0 ) {
+      piece.sender.seqno = msg.sender.seqno + static_cast<uint32_t>( msg.sender.SYN + offset );
+      piece.sender.SYN = false;
+      piece.sender.SACK_permitted = false;
+      piece.sender.window_scale.reset();
+      piece.sender.mss.reset();
+    }
+    datagrams.push_back( wrap_tcp_in_ip( piece ) );
+  }
+  return datagrams;
+}
@@ -4,7 +4,9 @@
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase
@@ -13,4 +15,14 @@ public:
   std::optional<TCPMessage> unwrap_tcp_in_ip( const InternetDatagram& ip_dgram );
 
   InternetDatagram wrap_tcp_in_ip( const TCPMessage& msg );
+
+  //! Like wrap_tcp_in_ip, but splits a payload larger than the peer's MSS into several segments
+  std::vector<InternetDatagram> wrap_tcp_in_ip_segments( const TCPMessage& msg );
+
+private:
+  // window scale shifts (RFC 7323) from our SYN and the peer's; windows are only scaled if both offered one
+  std::optional<uint8_t> local_window_scale_ {};
+  std::optional<uint8_t> remote_window_scale_ {};
+  // the peer's MSS, from its SYN
+  std::optional<uint16_t> remote_mss_ {};
 };
@@ -6,9 +6,13 @@
 #include "tcp_segment.hh"
 #include "tcp_sender.hh"
 #include "tcp_sender_message.hh"
+#include "timer_wheel.hh"
 
+#include <algorithm>
 #include <functional>
 #include <optional>
+#include <span>
+#include <vector>
 
 class TCPPeer
 {
@@ -18,7 +22,13 @@ class TCPPeer
   }
 
 public:
-  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg ) {}
+  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg )
+  {
+    sender_.set_mss( cfg_.mss, cfg_.super_segments );
+    sender_.set_nagle( cfg_.nagle );
+    sender_.set_timestamps( cfg_.timestamps );
+    restart_idle_timers();
+  }
 
   Writer& outbound_writer() { return sender_.writer(); }
   Reader& inbound_reader() { return receiver_.reader(); }
@@ -26,14 +36,47 @@ public:
   /* Type of the `transmit` function that the push and tick methods can use to send messages */
   using TransmitFunction = std::function<void( TCPMessage )>;
 
+  /* Type of the `transmit` function that push_batch uses to send a burst of messages at once */
+  using TransmitBatchFunction = std::function<void( std::span<const TCPMessage> )>;
+
   /* Passthrough methods */
   void push( const TransmitFunction& transmit ) { sender_.push( make_send( transmit ) ); }
+  void push_batch( const TransmitBatchFunction& transmit )
+  {
+    sender_.push_batch( [&]( std::span<const TCPSenderMessage> messages ) {
+      batch_.clear();
+      for ( const auto& x : messages ) {
+        batch_.push_back( make_message( x ) );
+      }
+      ack_sent();
+      transmit( batch_ );
+    } );
+  }
+  // While corked, only full segments of the outbound stream go out (until uncorking, or closing the stream).
+  void cork() { sender_.cork(); }
+  void uncork( const TransmitFunction& transmit )
+  {
+    sender_.uncork();
+    push( transmit );
+  }
   void tick( uint64_t t, const TransmitFunction& transmit )
   {
-    cumulative_time_ += t;
     sender_.tick( t, make_send( transmit ) );
+
+    timers_.advance( t, [&]( uint64_t timer ) {
+      // Give back buffer memory once the connection has gone idle.
+      if ( timer == IDLE_SHRINK_TIMER ) {
+        sender_.writer().shrink_to_fit();
+        receiver_.shrink_to_fit();
+      }
+
+      // Acknowledge data that no second segment (or outgoing data) has acknowledged in time.
+      if ( timer == DELAYED_ACK_TIMER ) {
+        send( sender_.make_empty_message(), transmit );
+      }
+    } );
   }
-  bool has_ackno() const { return receiver_.send().ackno.has_value(); }
+  bool has_ackno() const { return receiver_.ackno().has_value(); }
 
   /* Is the peer still active? */
   bool active() const
@@ -41,8 +84,7 @@ public:
     const bool any_errors = receiver_.reader().has_error() or sender_.writer().has_error();
     const bool sender_active = sender_.sequence_numbers_in_flight() or not sender_.reader().is_finished();
     const bool receiver_active = not receiver_.writer().is_closed();
-    const bool lingering
-      = linger_after_streams_finish_ and ( cumulative_time_ < time_of_last_receipt_ + 10UL * cfg_.rt_timeout );
+    const bool lingering = linger_after_streams_finish_ and timers_.armed( linger_timer_ );
 
     return ( not any_errors ) and ( sender_active or receiver_active or lingering );
   }
@@ -53,29 +95,57 @@ public:
       return;
     }
 
-    // Record time in case this peer has to linger after streams finish.
-    time_of_last_receipt_ = cumulative_time_;
-
-    // If SenderMessage occupies a sequence number, make sure to reply.
-    need_send_ |= ( msg.sender.sequence_length() > 0 );
+    // Restart the clock in case this peer has to linger after streams finish (or goes idle).
+    restart_idle_timers();
 
     // If SenderMessage is a "keep-alive" (with intentionally invalid seqno), make sure to reply.
     // (N.B. orthodox TCP rules require a reply on any unacceptable segment.)
-    const auto our_ackno = receiver_.send().ackno;
+    const auto our_ackno = receiver_.ackno();
     need_send_ |= ( our_ackno.has_value() and msg.sender.seqno + 1 == our_ackno.value() );
 
+    // If SenderMessage occupies a sequence number, make sure to reply: right away, unless it is in-order data
+    // that can wait for a second segment (or the delayed-ACK timer) to share one acknowledgment (RFC 1122).
+    const bool occupies_seqno = msg.sender.sequence_length() > 0;
+    const bool can_delay = cfg_.delayed_ack_ms > 0 and not msg.sender.SYN and not msg.sender.FIN
+                           and our_ackno == msg.sender.seqno and receiver_.reassembler().bytes_pending() == 0;
+    unacked_bytes_ += msg.sender.payload.size();
+
     // Did the inbound stream finish before the outbound stream? If so, no need to linger after streams finish.
     if ( receiver_.writer().is_closed() and not sender_.reader().is_finished() ) {
       linger_after_streams_finish_ = false;
     }
 
+    // The peer's first SYN says how large a segment it accepts, and whether it takes part in timestamps.
+    // (N.B. a retransmitted SYN mustn't renegotiate: set_mss() would restart congestion control.)
+    if ( msg.sender.SYN and not our_ackno.has_value() ) {
+      if ( msg.sender.mss.has_value() ) {
+        sender_.set_mss( std::min( cfg_.mss, std::max( *msg.sender.mss, TCPConfig::MIN_MSS ) ),
+                         cfg_.super_segments );
+      }
+      sender_.set_timestamps( cfg_.timestamps and msg.sender.timestamp.has_value() );
+    }
+    if ( not cfg_.timestamps ) {
+      msg.sender.timestamp.reset(); // (we didn't offer them, so the peer's mean nothing)
+    }
+
     // Give incoming TCPSenderMessage to receiver.
     receiver_.receive( std::move( msg.sender ) );
 
     // Give incoming TCPReceiverMessage to sender.
     sender_.receive( msg.receiver );
 
-    // Send reply if needed.
+    // Out-of-order data, and data that fills a hole, is acknowledged right away (RFC 5681).
+    if ( occupies_seqno ) {
+      if ( can_delay and receiver_.reassembler().bytes_pending() == 0 and unacked_bytes_ < 2UL * sender_.mss() ) {
+        if ( not timers_.armed( delayed_ack_timer_ ) ) {
+          delayed_ack_timer_ = timers_.arm( cfg_.delayed_ack_ms, DELAYED_ACK_TIMER );
+        }
+      } else {
+        need_send_ = true;
+      }
+    }
+
+    // Send reply if needed (any data we send carries the acknowledgment too).
     push( transmit );
     if ( need_send_ ) {
       send( sender_.make_empty_message(), transmit );
@@ -88,19 +158,59 @@ public:
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { ByteStream { cfg_.send_capacity, ByteStream::Storage::Chunked },
+                     cfg_.isn,
+                     cfg_.rt_timeout,
+                     cfg_.congestion_control,
+                     RTOLimits { TCPConfig::MIN_RTO_MS, TCPConfig::MAX_RTO_MS } };
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity, ByteStream::Storage::Chunked } },
+                          cfg_.window_scale() };
 
   bool need_send_ {};
+  std::vector<TCPMessage> batch_ {};
 
-  void send( const TCPSenderMessage& sender_message, const TransmitFunction& transmit )
+  TCPMessage make_message( const TCPSenderMessage& sender_message ) const
   {
     TCPMessage msg { sender_message, receiver_.send() };
-    transmit( std::move( msg ) );
+    // The window scale and MSS belong to the receiving side, but go out in our SYN.
+    if ( msg.sender.SYN ) {
+      msg.sender.window_scale = receiver_.window_scale();
+      msg.sender.mss = cfg_.mss;
+    }
+    return msg;
+  }
+
+  void send( const TCPSenderMessage& sender_message, const TransmitFunction& transmit )
+  {
+    transmit( make_message( sender_message ) );
+    ack_sent();
+  }
+
+  // Every message we send acknowledges everything received so far.
+  void ack_sent()
+  {
     need_send_ = false;
+    unacked_bytes_ = 0;
+    timers_.cancel( delayed_ack_timer_ );
   }
 
   bool linger_after_streams_finish_ { true }; // one peer may need to linger to make sure all closure conditions met
-  uint64_t cumulative_time_ {};
-  uint64_t time_of_last_receipt_ {};
+
+  // Timers that run from the last receipt: lingering, giving back buffer memory, and delayed acknowledgment
+  static constexpr uint64_t LINGER_TIMER = 0;
+  static constexpr uint64_t IDLE_SHRINK_TIMER = 1;
+  static constexpr uint64_t DELAYED_ACK_TIMER = 2; // runs from the first received segment not yet acknowledged
+  TimerWheel timers_ {};
+  TimerWheel::Handle linger_timer_ {};
+  TimerWheel::Handle idle_shrink_timer_ {};
+  TimerWheel::Handle delayed_ack_timer_ {};
+  uint64_t unacked_bytes_ {}; // payload received since our last acknowledgment
+
+  void restart_idle_timers()
+  {
+    timers_.cancel( linger_timer_ );
+    timers_.cancel( idle_shrink_timer_ );
+    linger_timer_ = timers_.arm( 10UL * cfg_.rt_timeout, LINGER_TIMER );
+    idle_shrink_timer_ = timers_.arm( TCPConfig::IDLE_SHRINK_MS, IDLE_SHRINK_TIMER );
+  }
 };
@@ -2,26 +2,48 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains three fields:
+ * It contains five fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
  *
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
- *    the <cstdint> header).
+ *    the <cstdint> header), unless both ends negotiated window scaling (RFC 7323) in their SYNs.
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) The SACK blocks: ranges of sequence numbers beyond the ackno that the TCP receiver already holds
+ *    (RFC 2018), the one holding the most recently received segment first. Empty unless the sender's
+ *    SYN permitted them.
+ *
+ * 5) The timestamp echo (RFC 7323): the timestamp of the segment this acknowledgment answers, for the
+ *    sender to measure the round trip with. Empty unless the sender's segments carry timestamps.
  */
 
+// A block of sequence numbers the receiver holds: [left, right)
+struct SACKBlock
+{
+  Wrap32 left;
+  Wrap32 right;
+};
+
 struct TCPReceiverMessage
 {
   std::optional<Wrap32> ackno {};
-  uint16_t window_size {};
+  uint32_t window_size {};
   bool RST {};
+  std::vector<SACKBlock> sack_blocks {};
+  std::optional<uint32_t> timestamp_echo {};
+
+  static constexpr size_t MAX_SACK_BLOCKS = 4; // as many as fit in the TCP header's option space
+  static constexpr size_t MAX_SACK_BLOCKS_WITH_TIMESTAMP = 3; // ... alongside the timestamp option
 };
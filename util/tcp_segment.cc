@@ -2,12 +2,94 @@
 #include "checksum.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 
 static constexpr uint32_t TCPHeaderMinLen = 5; // 32-bit words
 
+// TCP option kinds
+static constexpr uint8_t TCPOptionEnd = 0;
+static constexpr uint8_t TCPOptionNop = 1;
+static constexpr uint8_t TCPOptionMSS = 2;
+static constexpr uint8_t TCPOptionWindowScale = 3;
+static constexpr uint8_t TCPOptionSACKPermitted = 4;
+static constexpr uint8_t TCPOptionSACK = 5;
+static constexpr uint8_t TCPOptionTimestamp = 8;
+
 using namespace std;
 
+namespace {
+
+// parse `length` bytes of options, skipping any this implementation doesn't know
+void parse_options( Parser& parser, size_t length, TCPMessage& message )
+{
+  while ( length > 0 and not parser.has_error() ) {
+    uint8_t kind {};
+    parser.integer( kind );
+    --length;
+    if ( kind == TCPOptionEnd ) {
+      parser.remove_prefix( length );
+      return;
+    }
+    if ( kind == TCPOptionNop ) {
+      continue;
+    }
+
+    uint8_t option_length {};
+    parser.integer( option_length );
+    if ( option_length < 2 or option_length - 1U > length ) {
+      parser.set_error();
+      return;
+    }
+    length -= option_length - 1U;
+    const size_t body_length = option_length - 2U;
+
+    if ( kind == TCPOptionMSS and body_length == 2 ) {
+      uint16_t mss {};
+      parser.integer( mss );
+      message.sender.mss = mss;
+    } else if ( kind == TCPOptionWindowScale and body_length == 1 ) {
+      uint8_t shift {};
+      parser.integer( shift );
+      message.sender.window_scale = shift;
+    } else if ( kind == TCPOptionSACKPermitted and body_length == 0 ) {
+      message.sender.SACK_permitted = true;
+    } else if ( kind == TCPOptionSACK and body_length % 8 == 0 ) {
+      for ( size_t i = 0; i < body_length / 8; ++i ) {
+        uint32_t left {};
+        uint32_t right {};
+        parser.integer( left );
+        parser.integer( right );
+        message.receiver.sack_blocks.push_back( { Wrap32 { left }, Wrap32 { right } } );
+      }
+    } else if ( kind == TCPOptionTimestamp and body_length == 8 ) {
+      uint32_t value {};
+      uint32_t echo {};
+      parser.integer( value );
+      parser.integer( echo );
+      message.sender.timestamp = value;
+      // the echo only means something with the ACK flag
+      if ( message.receiver.ackno.has_value() ) {
+        message.receiver.timestamp_echo = echo;
+      }
+    } else {
+      parser.remove_prefix( body_length );
+    }
+  }
+}
+
+// SACK blocks share the option space with the timestamp
+size_t sack_blocks_to_send( const TCPMessage& message )
+{
+  const size_t max_blocks = message.sender.timestamp.has_value()
+                              ? TCPReceiverMessage::MAX_SACK_BLOCKS_WITH_TIMESTAMP
+                              : TCPReceiverMessage::MAX_SACK_BLOCKS;
+  return min( message.receiver.sack_blocks.size(), max_blocks );
+}
+
+} // namespace
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   /* verify checksum */
@@ -43,17 +125,21 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   message.sender.SYN = octet & 0b0000'0010;
   message.sender.FIN = octet & 0b0000'0001;
 
-  parser.integer( message.receiver.window_size );
+  parser.integer( raw16 );
+  message.receiver.window_size = raw16;
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
+  // the options fill out the rest of the header
   if ( data_offset < TCPHeaderMinLen ) {
     parser.set_error();
+    return;
   }
-  parser.remove_prefix( data_offset * 4 - TCPHeaderMinLen * 4 );
+  parse_options( parser, data_offset * 4 - TCPHeaderMinLen * 4, message );
 
-  parser.all_remaining( message.sender.payload );
+  string payload;
+  parser.all_remaining( payload );
+  message.sender.payload = move( payload );
 }
 
 class Wrap32Serializable : public Wrap32
@@ -64,19 +150,75 @@ public:
 
 void TCPSegment::serialize( Serializer& serializer ) const
 {
+  // options (each padded to a 32-bit boundary with leading NOPs)
+  const size_t sack_blocks = sack_blocks_to_send( message );
+  const bool sack_permitted = message.sender.SYN and message.sender.SACK_permitted;
+  const bool window_scale = message.sender.SYN and message.sender.window_scale.has_value();
+  const bool mss = message.sender.SYN and message.sender.mss.has_value();
+
   serializer.integer( udinfo.src_port );
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender.seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver.ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { TCPHeaderMinLen << 4 } ); // data offset
+  serializer.integer( static_cast<uint8_t>( header_length() / 4 << 4 ) ); // data offset
   const bool reset = message.sender.RST or message.receiver.RST;
   const uint8_t flags = ( message.receiver.ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender.SYN ? 0b0000'0010U : 0 ) | ( message.sender.FIN ? 0b0000'0001U : 0 );
   serializer.integer( flags );
-  serializer.integer( message.receiver.window_size );
+  // NOTE: the window must already be scaled (by whoever negotiated the scale) to fit the field
+  serializer.integer( static_cast<uint16_t>( min<uint32_t>( message.receiver.window_size, UINT16_MAX ) ) );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
-  serializer.buffer( message.sender.payload );
+
+  if ( sack_permitted ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionSACKPermitted );
+    serializer.integer( uint8_t { 2 } );
+  }
+  if ( mss ) {
+    serializer.integer( TCPOptionMSS );
+    serializer.integer( uint8_t { 4 } );
+    serializer.integer( *message.sender.mss );
+  }
+  if ( window_scale ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionWindowScale );
+    serializer.integer( uint8_t { 3 } );
+    serializer.integer( *message.sender.window_scale );
+  }
+  if ( message.sender.timestamp.has_value() ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionTimestamp );
+    serializer.integer( uint8_t { 10 } );
+    serializer.integer( *message.sender.timestamp );
+    serializer.integer( message.receiver.timestamp_echo.value_or( 0 ) );
+  }
+  if ( sack_blocks > 0 ) {
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionNop );
+    serializer.integer( TCPOptionSACK );
+    serializer.integer( static_cast<uint8_t>( 2 + 8 * sack_blocks ) );
+    for ( size_t i = 0; i < sack_blocks; ++i ) {
+      serializer.integer( Wrap32Serializable { message.receiver.sack_blocks[i].left }.raw_value() );
+      serializer.integer( Wrap32Serializable { message.receiver.sack_blocks[i].right }.raw_value() );
+    }
+  }
+
+  serializer.buffer( string { message.sender.payload.view() } );
+}
+
+size_t TCPSegment::header_length() const
+{
+  const size_t sack_blocks = sack_blocks_to_send( message );
+  const bool sack_permitted = message.sender.SYN and message.sender.SACK_permitted;
+  const bool window_scale = message.sender.SYN and message.sender.window_scale.has_value();
+  const bool mss = message.sender.SYN and message.sender.mss.has_value();
+  const size_t timestamp_words = message.sender.timestamp.has_value() ? 3 : 0;
+  const size_t options_words
+    = mss + sack_permitted + window_scale + timestamp_words + ( sack_blocks > 0 ? 1 + 2 * sack_blocks : 0 );
+  return ( TCPHeaderMinLen + options_words ) * 4;
 }
 
 void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
@@ -19,5 +19,8 @@ struct TCPSegment
   void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
   void serialize( Serializer& serializer ) const;
 
+  // Length of the serialized header, including options, in bytes
+  size_t header_length() const;
+
   void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
 };
@@ -1,13 +1,16 @@
 #pragma once
 
+#include "buffer.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains five fields:
+ * It contains nine fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -15,11 +18,22 @@
  * 2) The SYN flag. If set, this segment is the beginning of the byte stream, and the seqno field
  *    contains the Initial Sequence Number (ISN) -- the zero point.
  *
- * 3) The payload: a substring (possibly empty) of the byte stream.
+ * 3) The payload: a substring (possibly empty) of the byte stream. Copies of the message share its bytes.
  *
  * 4) The FIN flag. If set, the payload represents the ending of the byte stream.
  *
  * 5) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 6) The SACK-permitted option (only meaningful with SYN). If set, the sender understands selective
+ *    acknowledgments, so the receiver on the other end may send them (RFC 2018).
+ *
+ * 7) The window scale option (only meaningful with SYN): the shift this end will apply to the windows it
+ *    advertises, if the other end also sends the option (RFC 7323).
+ *
+ * 8) The maximum segment size option (only meaningful with SYN): the largest payload this end will accept.
+ *
+ * 9) The timestamp option (RFC 7323): the sender's clock, in milliseconds, when it sent the segment. Sent on
+ *    every segment once both SYNs carried one.
  */
 
 struct TCPSenderMessage
@@ -27,11 +41,16 @@ struct TCPSenderMessage
   Wrap32 seqno { 0 };
 
   bool SYN {};
-  std::string payload {};
+  Buffer payload {};
   bool FIN {};
 
   bool RST {};
 
+  bool SACK_permitted {};
+  std::optional<uint8_t> window_scale {};
+  std::optional<uint16_t> mss {};
+  std::optional<uint32_t> timestamp {};
+
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
 };
@@ -0,0 +1,147 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+array<uint32_t, TimerWheel::LEVELS * TimerWheel::SLOTS> TimerWheel::make_empty_slots()
+{
+  array<uint32_t, LEVELS * SLOTS> slots {};
+  slots.fill( NONE );
+  return slots;
+}
+
+TimerWheel::Handle TimerWheel::arm( uint64_t delay_ms, uint64_t tag )
+{
+  uint32_t index = free_;
+  if ( index == NONE ) {
+    index = static_cast<uint32_t>( nodes_.size() );
+    nodes_.emplace_back();
+  } else {
+    free_ = nodes_[index].next;
+  }
+
+  constexpr uint64_t max_delay_ms = ( uint64_t { 1 } << ( SLOT_BITS * LEVELS ) ) - 1;
+  Node& node = nodes_[index];
+  node.expiry_ms = now_ms_ + clamp<uint64_t>( delay_ms, 1, max_delay_ms );
+  node.tag = tag;
+  link( index );
+  ++armed_;
+  return { index, node.generation };
+}
+
+bool TimerWheel::armed( const Handle& handle ) const
+{
+  return handle.index < nodes_.size() and nodes_[handle.index].generation == handle.generation
+         and nodes_[handle.index].slot != NONE;
+}
+
+void TimerWheel::cancel( Handle& handle )
+{
+  if ( armed( handle ) ) {
+    release( handle.index );
+  }
+  handle = {};
+}
+
+void TimerWheel::release( uint32_t index )
+{
+  unlink( index );
+  Node& node = nodes_[index];
+  ++node.generation;
+  node.next = free_;
+  free_ = index;
+  --armed_;
+}
+
+void TimerWheel::link( uint32_t index )
+{
+  // the lowest level whose current rotation the expiry falls in
+  Node& node = nodes_[index];
+  size_t level = 0;
+  while ( level + 1 < LEVELS ) {
+    const size_t rotation_bits = SLOT_BITS * ( level + 1 );
+    if ( ( node.expiry_ms >> rotation_bits ) == ( now_ms_ >> rotation_bits ) ) {
+      break;
+    }
+    ++level;
+  }
+
+  const uint64_t slot_in_level = ( node.expiry_ms >> ( SLOT_BITS * level ) ) & ( SLOTS - 1 );
+  node.slot = static_cast<uint32_t>( level * SLOTS + slot_in_level );
+  node.prev = NONE;
+  node.next = heads_[node.slot];
+  if ( node.next != NONE ) {
+    nodes_[node.next].prev = index;
+  }
+  heads_[node.slot] = index;
+  ++level_sizes_[level];
+}
+
+void TimerWheel::unlink( uint32_t index )
+{
+  Node& node = nodes_[index];
+  if ( node.prev != NONE ) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    heads_[node.slot] = node.next;
+  }
+  if ( node.next != NONE ) {
+    nodes_[node.next].prev = node.prev;
+  }
+  --level_sizes_[node.slot / SLOTS];
+  node.slot = NONE;
+}
+
+void TimerWheel::cascade( size_t level )
+{
+  // these timers expire within the rotation of a lower level that is starting now
+  const size_t slot = level * SLOTS + ( ( now_ms_ >> ( SLOT_BITS * level ) ) & ( SLOTS - 1 ) );
+  while ( heads_[slot] != NONE ) {
+    const uint32_t index = heads_[slot];
+    unlink( index );
+    link( index );
+  }
+}
+
+void TimerWheel::advance( uint64_t ms, const function<void( uint64_t )>& on_expire )
+{
+  const uint64_t target_ms = now_ms_ + ms;
+  while ( now_ms_ < target_ms ) {
+    if ( armed_ == 0 ) {
+      now_ms_ = target_ms;
+      break;
+    }
+
+    // timers at the lowest occupied level can't expire before that level's next slot begins, so skip to it
+    size_t level = 0;
+    while ( level_sizes_[level] == 0 ) {
+      ++level;
+    }
+    const uint64_t slot_ms = uint64_t { 1 } << ( SLOT_BITS * level );
+    const uint64_t next_ms = ( now_ms_ / slot_ms + 1 ) * slot_ms;
+    if ( next_ms > target_ms ) {
+      now_ms_ = target_ms;
+      break;
+    }
+    now_ms_ = next_ms;
+
+    // at the start of a rotation, bring the next slot's timers down from the level above (top-down)
+    size_t top = 0;
+    while ( top + 1 < LEVELS and now_ms_ % ( uint64_t { 1 } << ( SLOT_BITS * ( top + 1 ) ) ) == 0 ) {
+      ++top;
+    }
+    for ( size_t l = top; l > 0; --l ) {
+      cascade( l );
+    }
+
+    // fire the timers that expire now
+    const size_t slot = now_ms_ & ( SLOTS - 1 );
+    while ( heads_[slot] != NONE ) {
+      const uint32_t index = heads_[slot];
+      const uint64_t tag = nodes_[index].tag;
+      release( index );
+      on_expire( tag );
+    }
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+ * A hierarchical timer wheel, with millisecond resolution. Arming and cancelling a timer take constant time,
+ * and advancing the clock only does work for the timers that expire (or move down a level) in the meantime,
+ * however many timers are armed or however far the clock moves.
+ *
+ * Each timer carries a caller-chosen `tag`, which advance() passes to its callback when the timer expires.
+ */
+class TimerWheel
+{
+public:
+  // Identifies an armed timer (a default-constructed handle identifies none)
+  struct Handle
+  {
+    uint32_t index { UINT32_MAX };
+    uint32_t generation {};
+  };
+
+  // Arm a timer to expire `delay_ms` from now (at least 1 ms, so it never expires within the current advance)
+  Handle arm( uint64_t delay_ms, uint64_t tag );
+
+  // Disarm a timer. It's fine to cancel a timer that already expired or was already cancelled.
+  void cancel( Handle& handle );
+
+  // Is the timer still armed?
+  bool armed( const Handle& handle ) const;
+
+  // Move the clock forward, calling `on_expire( tag )` for each timer that expires (in order of expiry).
+  // The callback may arm and cancel timers.
+  void advance( uint64_t ms, const std::function<void( uint64_t )>& on_expire );
+
+  uint64_t now_ms() const { return now_ms_; }
+  size_t size() const { return armed_; } // How many timers are armed?
+
+private:
+  static constexpr size_t SLOT_BITS = 6;
+  static constexpr size_t SLOTS = 1 << SLOT_BITS; // per level
+  static constexpr size_t LEVELS = 8;             // covering delays up to 2^48 ms
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct Node
+  {
+    uint64_t expiry_ms {};
+    uint64_t tag {};
+    uint32_t generation {};
+    uint32_t prev { NONE };
+    uint32_t next { NONE };
+    uint32_t slot { NONE }; // level * SLOTS + slot within the level, or NONE if free
+  };
+
+  uint64_t now_ms_ {};
+  size_t armed_ {};
+  std::vector<Node> nodes_ {};
+  uint32_t free_ { NONE }; // free nodes, linked through `next`
+  std::array<uint32_t, LEVELS * SLOTS> heads_ = make_empty_slots();
+  std::array<size_t, LEVELS> level_sizes_ {};
+
+  static std::array<uint32_t, LEVELS * SLOTS> make_empty_slots();
+
+  void link( uint32_t index );    // put an armed node in the slot for its expiry
+  void unlink( uint32_t index );  // take a node out of its slot
+  void release( uint32_t index ); // disarm a node and free it
+  void cascade( size_t level );   // move the current slot's timers at `level` down to where they now belong
+};